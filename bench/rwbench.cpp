@@ -0,0 +1,451 @@
+// Scaling benchmark for rwc and for the code it generates.
+//
+// Generates synthetic headers that grow along one dimension at a time (namespaces, classes, methods, overloads, enumerators
+// and template aliases), runs rwc on each of them and then compiles the generated metadata. Wall time and peak memory of every
+// step go to a CSV file, one line per header, so that the curves of two builds can be compared.
+// Given the runtime library, it also builds the runtime models of every header, DNamespaceWrapper and ArenaModel, and records
+// how long that takes and how much memory they allocate.
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+    /**
+     * @brief HeaderShape describes a synthetic header. Every namespace gets the same content.
+     */
+    struct HeaderShape {
+        int namespaces = 2;
+        int classes = 8;        // per namespace
+        int methods = 8;        // per class
+        int overloads = 2;      // per method
+        int enumerators = 32;   // of the single enum of every namespace
+        int aliases = 2;        // template aliases, per namespace
+
+        int *dimension(std::string_view name) {
+            if (name == "namespaces") return &namespaces;
+            if (name == "classes") return &classes;
+            if (name == "methods") return &methods;
+            if (name == "overloads") return &overloads;
+            if (name == "enumerators") return &enumerators;
+            if (name == "aliases") return &aliases;
+            return nullptr;
+        }
+    };
+
+    const std::vector<std::string> allSeries = {"namespaces", "classes", "methods", "overloads", "enumerators", "aliases"};
+
+    struct Options {
+        std::string rwc = "rwc";
+        std::string cxx = "c++";
+        std::string includeDirectory;
+        std::string workDirectory = "rwbench";
+        std::string output = "rwbench.csv";
+        HeaderShape shape;
+        std::vector<int> scales = {1, 2, 4, 8, 16};
+        std::vector<std::string> series = allSeries;
+        int repeat = 1;
+        std::vector<std::string> cxxArguments;
+        // rwruntime, to link the runtime model benchmarks with. They are skipped without it
+        std::string runtimeLibrary;
+        // everything after --
+        std::vector<std::string> rwcArguments;
+    };
+
+    struct Measurement {
+        double seconds = 0.;
+        long maxRssKb = 0;
+        bool succeeded = false;
+    };
+
+    // what the runtime model benchmark reports for each model
+    struct ModelMeasurement {
+        double seconds = 0.;
+        unsigned long bytes = 0;
+        unsigned long allocations = 0;
+    };
+
+    // counts what the models allocate through a replaced operator new, and keeps the fastest of a few constructions
+    constexpr std::string_view runtimeDriver = R"(#include "{0}.h"
+#include "{0}.metadata.h"
+
+#include <rosewood/arena.hpp>
+#include <rosewood/runtime.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {{
+    std::size_t allocations = 0;
+    std::size_t allocatedBytes = 0;
+
+    template <typename Build>
+    void measure(Build build) {{
+        allocations = allocatedBytes = 0;
+        {{
+            auto model = build();
+            static_cast<void>(model);
+        }}
+        const std::size_t modelAllocations = allocations, modelBytes = allocatedBytes;
+        double best = 0.;
+        for (int run(0); run < 20; ++run) {{
+            const auto start = std::chrono::steady_clock::now();
+            auto model = build();
+            static_cast<void>(model);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = run == 0 || seconds < best ? seconds : best;
+        }}
+        std::printf("%.9f,%zu,%zu", best, modelBytes, modelAllocations);
+    }}
+}}
+
+void *operator new(std::size_t size) {{
+    ++allocations;
+    allocatedBytes += size;
+    if (void *memory = std::malloc(size ? size : 1)) {{
+        return memory;
+    }}
+    throw std::bad_alloc();
+}}
+
+void operator delete(void *memory) noexcept {{
+    std::free(memory);
+}}
+
+void operator delete(void *memory, std::size_t) noexcept {{
+    std::free(memory);
+}}
+
+int main() {{
+    measure([] {{ return rosewood::DNamespaceWrapper(rosewood::meta_{0}{{}}, nullptr); }});
+    std::printf(",");
+    measure([] {{ return rosewood::ArenaModel(rosewood::meta_{0}{{}}); }});
+    std::printf("\n");
+    return 0;
+}}
+)";
+
+    std::vector<std::string> split(std::string_view list) {
+        std::vector<std::string> items;
+        while (!list.empty()) {
+            const auto comma = std::min(list.find(','), list.size());
+            if (comma > 0) {
+                items.emplace_back(list.substr(0, comma));
+            }
+            list.remove_prefix(std::min(comma + 1, list.size()));
+        }
+        return items;
+    }
+
+    void usage() {
+        fmt::print(stderr,
+            "usage: rwbench [options] [-- <arguments passed on to rwc after its own -->]\n"
+            "  --rwc <path>          rwc executable (default: rwc)\n"
+            "  --cxx <path>          compiler used on the generated metadata (default: c++)\n"
+            "  --include <dir>       directory holding rosewood/rosewood.hpp\n"
+            "  --work-dir <dir>      where headers and outputs are generated (default: rwbench)\n"
+            "  --output <file>       CSV results (default: rwbench.csv)\n"
+            "  --shape <list>        comma separated <dimension>=<value> pairs overriding the base shape of the headers\n"
+            "  --scales <list>       comma separated scale factors (default: 1,2,4,8,16)\n"
+            "  --series <list>       comma separated dimensions to scale, among {}\n"
+            "  --repeat <count>      runs per measurement, the fastest one is kept (default: 1)\n"
+            "  --cxx-arg <argument>  extra argument for the compiler, may be repeated\n"
+            "  --runtime <library>   rwruntime, also benchmarks building the runtime models of every header\n",
+            fmt::join(allSeries, ","));
+    }
+
+    std::optional<Options> parseOptions(int argc, char **argv) {
+        Options options;
+        for (int idx(1); idx < argc; ++idx) {
+            const std::string_view argument(argv[idx]);
+            if (argument == "--") {
+                options.rwcArguments.assign(argv + idx + 1, argv + argc);
+                break;
+            }
+            if (idx + 1 >= argc) {
+                fmt::print(stderr, "rwbench: {} is either unknown or lacks a value\n", argument);
+                return std::nullopt;
+            }
+            const std::string value(argv[++idx]);
+            if (argument == "--rwc") {
+                options.rwc = value;
+            } else if (argument == "--cxx") {
+                options.cxx = value;
+            } else if (argument == "--include") {
+                options.includeDirectory = value;
+            } else if (argument == "--work-dir") {
+                options.workDirectory = value;
+            } else if (argument == "--output") {
+                options.output = value;
+            } else if (argument == "--shape") {
+                for (const auto &assignment: split(value)) {
+                    const auto equals = assignment.find('=');
+                    int *dimension = options.shape.dimension(std::string_view(assignment).substr(0, equals));
+                    if (equals == std::string::npos || !dimension) {
+                        fmt::print(stderr, "rwbench: {} doesn't assign a known dimension\n", assignment);
+                        return std::nullopt;
+                    }
+                    *dimension = std::max(1, std::atoi(assignment.c_str() + equals + 1));
+                }
+            } else if (argument == "--scales") {
+                options.scales.clear();
+                for (const auto &scale: split(value)) {
+                    options.scales.push_back(std::max(1, std::atoi(scale.c_str())));
+                }
+            } else if (argument == "--series") {
+                options.series = split(value);
+                for (const auto &series: options.series) {
+                    if (!HeaderShape().dimension(series)) {
+                        fmt::print(stderr, "rwbench: unknown series {}\n", series);
+                        return std::nullopt;
+                    }
+                }
+            } else if (argument == "--repeat") {
+                options.repeat = std::max(1, std::atoi(value.c_str()));
+            } else if (argument == "--cxx-arg") {
+                options.cxxArguments.push_back(value);
+            } else if (argument == "--runtime") {
+                options.runtimeLibrary = value;
+            } else {
+                fmt::print(stderr, "rwbench: unknown option {}\n", argument);
+                return std::nullopt;
+            }
+        }
+        return options;
+    }
+
+    template<typename ...Args>
+    void append(fmt::memory_buffer &out, std::string_view format, const Args &...args) {
+        fmt::vformat_to(std::back_inserter(out), format, fmt::make_format_args(args...));
+    }
+
+    std::string generateHeader(const HeaderShape &shape) {
+        fmt::memory_buffer buffer;
+        auto put = [&buffer] (std::string_view format, const auto &...args) { append(buffer, format, args...); };
+
+        put("#pragma once\n#include <string>\n#include <vector>\n\n");
+        for (int ns(0); ns < shape.namespaces; ++ns) {
+            put("namespace bench_ns{} {{\n\n", ns);
+
+            put("enum class Enum{} {{\n", ns);
+            for (int en(0); en < shape.enumerators; ++en) {
+                put("    enumerator{} = {},\n", en, en * 3 - 7);
+            }
+            put("}};\n\n");
+
+            for (int cls(0); cls < shape.classes; ++cls) {
+                put("class Class{} {{\npublic:\n", cls);
+                put("    Class{}() = default;\n    explicit Class{}(int value) : field0(value) {{}}\n", cls, cls);
+                for (int method(0); method < shape.methods; ++method) {
+                    // inline bodies, so that the cost of parsing them shows
+                    put("    int method{}(int a) const {{ return a * {} + field0; }}\n", method, method + 1);
+                    // every further overload takes one more parameter
+                    std::string parameters = "int a";
+                    for (int overload(1); overload < shape.overloads; ++overload) {
+                        parameters += fmt::format(", double b{}", overload);
+                        put("    double method{}({}) {{ return a + b{} * {}; }}\n", method, parameters, overload, overload);
+                    }
+                }
+                put("    std::string describe() const {{ return std::to_string(field0) + field1; }}\n");
+                put("    int field0 = 0;\n    std::string field1;\n    std::vector<int> field2;\n}};\n\n");
+            }
+
+            put("template <int N>\nstruct Tagged {{\n    int get() const {{ return N * value; }}\n    int value = 1;\n}};\n\n");
+            for (int alias(0); alias < shape.aliases; ++alias) {
+                put("using Tagged{} = Tagged<{}>;\n", alias, alias);
+            }
+            put("\n}}\n\n");
+        }
+        return fmt::to_string(buffer);
+    }
+
+    bool writeFile(const std::string &path, const std::string &contents) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << contents;
+        return static_cast<bool>(file.flush());
+    }
+
+    /**
+     * @brief run executes a command and waits for it. Its standard output and error go to logPath.
+     */
+    Measurement run(const std::vector<std::string> &command, const std::string &logPath) {
+        Measurement measurement;
+        const auto start = std::chrono::steady_clock::now();
+        const pid_t pid = fork();
+        if (pid < 0) {
+            return measurement;
+        }
+        if (pid == 0) {
+            const int log = open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (log >= 0) {
+                dup2(log, STDOUT_FILENO);
+                dup2(log, STDERR_FILENO);
+                close(log);
+            }
+            std::vector<char*> argv;
+            for (const auto &argument: command) {
+                argv.push_back(const_cast<char*>(argument.c_str()));
+            }
+            argv.push_back(nullptr);
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+
+        int status = 0;
+        rusage usage{};
+        // wait4 reports the resources of that one child, unlike getrusage(RUSAGE_CHILDREN) which keeps the maximum of all of them
+        if (wait4(pid, &status, 0, &usage) != pid) {
+            return measurement;
+        }
+        measurement.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        measurement.maxRssKb = usage.ru_maxrss;
+        measurement.succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        return measurement;
+    }
+
+    Measurement runRepeatedly(const std::vector<std::string> &command, const std::string &logPath, int repeat) {
+        Measurement best;
+        for (int idx(0); idx < repeat; ++idx) {
+            const auto measurement = run(command, logPath);
+            if (!measurement.succeeded) {
+                fmt::print(stderr, "rwbench: `{}` failed, see {}\n", fmt::join(command, " "), logPath);
+                return measurement;
+            }
+            if (idx == 0 || measurement.seconds < best.seconds) {
+                best.seconds = measurement.seconds;
+            }
+            best.maxRssKb = std::max(best.maxRssKb, measurement.maxRssKb);
+            best.succeeded = true;
+        }
+        return best;
+    }
+
+    std::optional<std::pair<ModelMeasurement, ModelMeasurement>> readModelMeasurements(const std::string &path) {
+        std::ifstream file(path);
+        std::string line;
+        std::pair<ModelMeasurement, ModelMeasurement> models;
+        if (!std::getline(file, line) || std::sscanf(line.c_str(), "%lf,%lu,%lu,%lf,%lu,%lu", &models.first.seconds, &models.first.bytes, &models.first.allocations,
+                                                     &models.second.seconds, &models.second.bytes, &models.second.allocations) != 6) {
+            return std::nullopt;
+        }
+        return models;
+    }
+
+    long fileSize(const std::string &path) {
+        struct stat status{};
+        return stat(path.c_str(), &status) == 0 ? static_cast<long>(status.st_size) : -1;
+    }
+
+}
+
+int main(int argc, char **argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        usage();
+        return 1;
+    }
+    mkdir(options->workDirectory.c_str(), 0755);
+
+    std::ofstream csv(options->output, std::ios::trunc);
+    if (!csv) {
+        fmt::print(stderr, "rwbench: could not open {}\n", options->output);
+        return 1;
+    }
+    const std::string columns = "series,scale,namespaces,classes,methods,overloads,enumerators,aliases,header_bytes,metadata_bytes,"
+                                "rwc_seconds,rwc_max_rss_kb,header_cxx_seconds,header_cxx_max_rss_kb,metadata_cxx_seconds,metadata_cxx_max_rss_kb,"
+                                "wrapper_model_seconds,wrapper_model_bytes,wrapper_model_allocations,arena_model_seconds,arena_model_bytes,arena_model_allocations";
+    csv << columns << '\n';
+    fmt::print("{}\n", columns);
+
+    std::vector<std::string> includeArguments;
+    if (!options->includeDirectory.empty()) {
+        includeArguments.push_back("-I" + options->includeDirectory);
+    }
+    includeArguments.push_back("-I" + options->workDirectory);
+
+    int result = 0;
+    for (const auto &series: options->series) {
+        for (const int scale: options->scales) {
+            HeaderShape shape = options->shape;
+            *shape.dimension(series) *= scale;
+
+            const std::string name = fmt::format("{}_{}", series, scale);
+            const std::string base = fmt::format("{}/{}", options->workDirectory, name);
+            const std::string header = base + ".h";
+            const std::string metadata = base + ".metadata.h";
+            const std::string headerSource = base + ".header.cpp";
+            const std::string metadataSource = base + ".metadata.cpp";
+            if (!writeFile(header, generateHeader(shape))
+                || !writeFile(headerSource, fmt::format("#include \"{}.h\"\n", name))
+                || !writeFile(metadataSource, fmt::format("#include \"{}.h\"\n#include \"{}.metadata.h\"\n", name, name))) {
+                fmt::print(stderr, "rwbench: could not write to {}\n", options->workDirectory);
+                return 1;
+            }
+
+            std::vector<std::string> rwcCommand = {options->rwc, header, "-n", name, "-o", metadata, "-j", base + ".metadata.rwdb", "--",
+                                                   "-x", "c++", "-std=c++17", "-fsyntax-only", "-Wno-pragma-once-outside-header"};
+            rwcCommand.insert(rwcCommand.end(), includeArguments.begin(), includeArguments.end());
+            rwcCommand.insert(rwcCommand.end(), options->rwcArguments.begin(), options->rwcArguments.end());
+
+            auto compileCommand = [&] (const std::string &source) {
+                std::vector<std::string> command = {options->cxx, "-std=c++17", "-c", source, "-o", source + ".o"};
+                command.insert(command.end(), includeArguments.begin(), includeArguments.end());
+                command.insert(command.end(), options->cxxArguments.begin(), options->cxxArguments.end());
+                return command;
+            };
+
+            const auto rwc = runRepeatedly(rwcCommand, base + ".rwc.log", options->repeat);
+            // the cost of the header alone, to be subtracted from the cost of the metadata
+            const auto headerCxx = runRepeatedly(compileCommand(headerSource), base + ".header.log", options->repeat);
+            const auto metadataCxx = rwc.succeeded ? runRepeatedly(compileCommand(metadataSource), base + ".metadata.log", options->repeat) : Measurement{};
+            if (!rwc.succeeded || !headerCxx.succeeded || !metadataCxx.succeeded) {
+                result = 1;
+            }
+
+            std::pair<ModelMeasurement, ModelMeasurement> models;
+            if (!options->runtimeLibrary.empty() && metadataCxx.succeeded) {
+                const std::string runtimeSource = base + ".runtime.cpp";
+                std::vector<std::string> command = {options->cxx, "-std=c++17", "-O2", runtimeSource, options->runtimeLibrary, "-o", base + ".runtime"};
+                command.insert(command.end(), includeArguments.begin(), includeArguments.end());
+                command.insert(command.end(), options->cxxArguments.begin(), options->cxxArguments.end());
+                const bool built = writeFile(runtimeSource, fmt::vformat(runtimeDriver, fmt::make_format_args(name))) && run(command, base + ".runtime-cxx.log").succeeded;
+                const auto measured = built && run({base + ".runtime"}, base + ".runtime.log").succeeded ? readModelMeasurements(base + ".runtime.log") : std::nullopt;
+                if (measured) {
+                    models = *measured;
+                } else {
+                    fmt::print(stderr, "rwbench: could not benchmark the runtime models of {}, see {}.runtime*.log\n", name, base);
+                    result = 1;
+                }
+            }
+
+            const std::string line = fmt::format("{},{},{},{},{},{},{},{},{},{},{:.3f},{},{:.3f},{},{:.3f},{},{:.9f},{},{},{:.9f},{},{}",
+                                                 series, scale, shape.namespaces, shape.classes, shape.methods, shape.overloads, shape.enumerators, shape.aliases,
+                                                 fileSize(header), fileSize(metadata),
+                                                 rwc.seconds, rwc.maxRssKb, headerCxx.seconds, headerCxx.maxRssKb, metadataCxx.seconds, metadataCxx.maxRssKb,
+                                                 models.first.seconds, models.first.bytes, models.first.allocations,
+                                                 models.second.seconds, models.second.bytes, models.second.allocations);
+            csv << line << '\n' << std::flush;
+            fmt::print("{}\n", line);
+        }
+    }
+    return result;
+}
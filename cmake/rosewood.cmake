@@ -1,6 +1,70 @@
 cmake_minimum_required(VERSION 3.9)
 
+# depfile paths are absolute either way but newer versions warn unless this is set. Functions keep the policies they were defined with
+if (POLICY CMP0116)
+    cmake_policy(SET CMP0116 NEW)
+endif()
+
+# rwc writes a depfile listing every file it read. Ninja has always understood the depfiles of custom commands, Makefiles do
+# since 3.20 and the rest since 3.21. Whatever else is left falls back to IMPLICIT_DEPENDS, which only Makefiles ever honored, on each of
+# headerFiles.
+function(_rosewood_dependency_arguments outVar headerFiles depFile)
+    if (CMAKE_GENERATOR MATCHES "Ninja"
+            OR (CMAKE_GENERATOR MATCHES "Makefiles" AND NOT CMAKE_VERSION VERSION_LESS 3.20)
+            OR NOT CMAKE_VERSION VERSION_LESS 3.21)
+        set(${outVar} DEPFILE ${depFile} PARENT_SCOPE)
+    else()
+        set(implicitDependencies)
+        foreach(headerFile ${headerFiles})
+            list(APPEND implicitDependencies CXX ${headerFile})
+        endforeach()
+        set(${outVar} IMPLICIT_DEPENDS ${implicitDependencies} PARENT_SCOPE)
+    endif()
+endfunction()
+
+# The descriptors of the types other modules reflect on already are referred to instead of being generated again. Their identifier
+# repositories, <name>.metadata.ids next to their metadata, are passed on with -import.
+function(_rosewood_import_arguments outVar)
+    set(importArguments)
+    foreach(repository ${ARGN})
+        list(APPEND importArguments -import ${repository})
+    endforeach()
+    set(${outVar} ${importArguments} PARENT_SCOPE)
+endfunction()
+
+# The headers rwc -declarations writes to directory are named after declarations, which aren't known before it runs. It lists them in
+# directory/manifest.txt, rewritten only when they come or go, and removes those of declarations that are gone. outVar gets that and
+# module-descriptors.h, which are always there, for OUTPUT. The whole directory goes on clean as of CMake 3.15.
+function(_rosewood_declaration_outputs outVar target directory)
+    if (NOT CMAKE_VERSION VERSION_LESS 3.15)
+        set_property(TARGET ${target} APPEND PROPERTY ADDITIONAL_CLEAN_FILES ${directory})
+    endif()
+    set(${outVar} ${directory}/manifest.txt ${directory}/module-descriptors.h PARENT_SCOPE)
+endfunction()
+
+# MODULE also writes <name>.metadata.cppm, the interface unit of the C++20 module <name>.meta exporting the descriptors, and adds it to
+# the CXX_MODULES file set of target. Its sources may then `import <name>.meta;` instead of including the generated header, which gets
+# parsed once for the whole target. This takes CMake 3.28 and a generator and compiler it supports modules with, e.g. Ninja and clang 16.
+function(_rosewood_add_module_interfaces target)
+    if (CMAKE_VERSION VERSION_LESS 3.28)
+        message(FATAL_ERROR "rosewood: MODULE needs CMake 3.28 or later to build C++20 module interfaces")
+    endif()
+    target_sources(${target} PRIVATE FILE_SET rosewood_metadata TYPE CXX_MODULES BASE_DIRS ${CMAKE_CURRENT_BINARY_DIR} FILES ${ARGN})
+    target_compile_features(${target} PRIVATE cxx_std_20)
+endfunction()
+
+# SPLIT moves the method, constructor, field and enumerator tables out of the generated header, into <name>.metadata.cpp which is
+# compiled once. Sources including the header then only pay for what they use, at the cost of these tables no longer being constexpr.
+# DECLARATION_HEADERS writes the descriptor of every class and enum declared in a namespace to a header of its own in <name>.metadata/,
+# <name>.metadata.h including them all. Sources may include just the ones they use, e.g. <name>.metadata/basic.Enum.h.
+# MODULE builds the descriptors as a C++20 module, see _rosewood_add_module_interfaces. It doesn't go with SPLIT.
+#   metacompile_header(<target> <header> [SPLIT] [DECLARATION_HEADERS] [MODULE] [IMPORTS <identifier repositories...>])
 function(metacompile_header target headerFile)
+    cmake_parse_arguments(PARSE_ARGV 2 ARG "SPLIT;DECLARATION_HEADERS;MODULE" "" "IMPORTS")
+    if (ARG_SPLIT AND ARG_MODULE)
+        message(FATAL_ERROR "rosewood: SPLIT and MODULE can't be combined")
+    endif()
+    _rosewood_import_arguments(importArguments ${ARG_IMPORTS})
     get_target_property(TGT_INCLUDE_DIRS ${target} INCLUDE_DIRECTORIES)
     get_target_property(TGT_DEFS ${target} COMPILE_DEFINITIONS)
     set(includeDirs  "$<TARGET_PROPERTY:${target},INCLUDE_DIRECTORIES>")
@@ -10,22 +74,58 @@ function(metacompile_header target headerFile)
     get_filename_component(filnenameWE ${headerFile} NAME_WE)
 
     set(outputCXXFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.h)
-    set(outputJsonFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.json)
+    set(outputDatabaseFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.rwdb)
+    set(depFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.d)
+    set(repositoryFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.ids)
+    set(layoutArguments)
+    set(outputSourceFile)
+    if (ARG_SPLIT)
+        set(outputSourceFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cpp)
+        set(layoutArguments -s ${outputSourceFile})
+    endif()
+    set(declarationFiles)
+    if (ARG_DECLARATION_HEADERS)
+        list(APPEND layoutArguments -declarations ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata)
+        _rosewood_declaration_outputs(declarationFiles ${target} ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata)
+    endif()
+    set(outputModuleFile)
+    if (ARG_MODULE)
+        set(outputModuleFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cppm)
+        list(APPEND layoutArguments -module-interface ${outputModuleFile})
+    endif()
+    _rosewood_dependency_arguments(dependencyArguments ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} ${depFile})
 
     add_custom_command(
-        COMMAND rwc ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} -n ${filnenameWE} -o ${outputCXXFile} -j ${outputJsonFile} -- -x c++ "$<$<BOOL:${includeDirs}>:-I$<JOIN:${includeDirs},;-I>>" "$<$<BOOL:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES}>:-I$<JOIN:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES},;-I>>" "$<$<BOOL:${compileDefs}>:-D$<JOIN:${compileDefs},;-D>>" ${cxxStandardFlag} -fsyntax-only -Wno-pragma-once-outside-header -nobuiltininc
-        OUTPUT ${outputCXXFile} ${outputJsonFile}
+        COMMAND rwc ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} -n ${filnenameWE} -o ${outputCXXFile} -j ${outputDatabaseFile} -d ${depFile} -i ${repositoryFile} ${layoutArguments} ${importArguments} -- -x c++ "$<$<BOOL:${includeDirs}>:-I$<JOIN:${includeDirs},;-I>>" "$<$<BOOL:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES}>:-I$<JOIN:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES},;-I>>" "$<$<BOOL:${compileDefs}>:-D$<JOIN:${compileDefs},;-D>>" ${cxxStandardFlag} -fsyntax-only -Wno-pragma-once-outside-header -nobuiltininc
+        OUTPUT ${outputCXXFile} ${outputDatabaseFile} ${repositoryFile} ${outputSourceFile} ${outputModuleFile} ${declarationFiles}
         COMMENT "Generating reflection data for ${headerFile}"
-        DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} rwc
-        IMPLICIT_DEPENDS CXX ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile}
+        DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} rwc ${ARG_IMPORTS}
+        ${dependencyArguments}
         COMMAND_EXPAND_LISTS
         )
-    target_sources(${target} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} ${outputCXXFile} ${outputJsonFile})
+    target_sources(${target} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} ${outputCXXFile} ${outputDatabaseFile} ${outputSourceFile})
     target_include_directories(${target} PUBLIC ${CMAKE_CURRENT_BINARY_DIR})
+    if (ARG_MODULE)
+        _rosewood_add_module_interfaces(${target} ${outputModuleFile})
+    endif()
 endfunction()
 
 
+# Reflects on every header of headerFiles and compiles the result into the generatedTargetName object library, which targetName links.
+# By default every header gets an rwc command of its own. With SINGLE_INVOCATION, a single rwc command parses all of them at once as
+# one translation unit, which saves parsing the headers they share over and over, and compiles the result as one source.
+# SPLIT compiles the tables of the generated headers out of line and DECLARATION_HEADERS gives every declaration a header of its own,
+# see metacompile_header. IMPORTS lists the identifier repositories of the modules the headers depend on, see _rosewood_import_arguments.
+# MODULE adds the module interface of every header to targetName, which imports them, see _rosewood_add_module_interfaces.
+#   rosewood_reflect_on_headers(<target> <generated target> <headers...> [SINGLE_INVOCATION] [SPLIT] [DECLARATION_HEADERS] [MODULE] [IMPORTS <identifier repositories...>])
 function(rosewood_reflect_on_headers targetName generatedTargetName headerFiles)
+    cmake_parse_arguments(PARSE_ARGV 3 ARG "SINGLE_INVOCATION;SPLIT;DECLARATION_HEADERS;MODULE" "" "IMPORTS")
+    if (ARG_SPLIT AND ARG_MODULE)
+        message(FATAL_ERROR "rosewood: SPLIT and MODULE can't be combined")
+    endif()
+    list(APPEND headerFiles ${ARG_UNPARSED_ARGUMENTS})
+    _rosewood_import_arguments(importArguments ${ARG_IMPORTS})
+
     set(includeDirs  "$<TARGET_PROPERTY:${targetName},INCLUDE_DIRECTORIES>")
     set(compileDefs  "$<TARGET_PROPERTY:${targetName},COMPILE_DEFINITIONS>")
     set(cxxStandard "$<TARGET_PROPERTY:${targetName},CXX_STANDARD>")
@@ -47,23 +147,101 @@ function(rosewood_reflect_on_headers targetName generatedTargetName headerFiles)
         endif()
     endif()
 
+    if (ARG_SINGLE_INVOCATION)
+        set(rwcArguments)
+        set(headerPaths)
+        set(outputFiles)
+        set(moduleFiles)
+        foreach(headerFile ${headerFiles})
+            get_filename_component(filnenameWE ${headerFile} NAME_WE)
+
+            set(outputCXXFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.h)
+            set(outputDatabaseFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.rwdb)
+            set(depFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.d)
+            set(repositoryFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.ids)
+            list(APPEND rwcArguments ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} -n ${filnenameWE} -o ${outputCXXFile} -j ${outputDatabaseFile} -d ${depFile} -i ${repositoryFile})
+            list(APPEND headerPaths ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile})
+            list(APPEND outputFiles ${outputCXXFile} ${outputDatabaseFile} ${repositoryFile})
+            if (ARG_SPLIT)
+                # included by the unit source rather than compiled on their own
+                list(APPEND rwcArguments -s ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cpp)
+                list(APPEND outputFiles ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cpp)
+                set_source_files_properties(${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cpp PROPERTIES HEADER_FILE_ONLY ON)
+            endif()
+            if (ARG_DECLARATION_HEADERS)
+                list(APPEND rwcArguments -declarations ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata)
+                _rosewood_declaration_outputs(declarationFiles ${generatedTargetName} ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata)
+                list(APPEND outputFiles ${declarationFiles})
+            endif()
+            if (ARG_MODULE)
+                list(APPEND rwcArguments -module-interface ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cppm)
+                list(APPEND moduleFiles ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cppm)
+            endif()
+        endforeach()
+
+        # the depfile of the unit source lists everything the translation unit read. Its rule names the unit source, which comes first
+        # among the outputs as older Ninja versions insist on
+        set(unitSource ${CMAKE_CURRENT_BINARY_DIR}/${generatedTargetName}.metadata.cpp)
+        _rosewood_dependency_arguments(dependencyArguments "${headerPaths}" ${unitSource}.d)
+
+        add_custom_command(
+            COMMAND rwc ${rwcArguments} -umbrella ${unitSource} ${importArguments} -- -x c++ "$<$<BOOL:${includeDirs}>:-I$<JOIN:${includeDirs},;-I>>" "$<$<BOOL:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES}>:-I$<JOIN:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES},;-I>>" "$<$<BOOL:${compileDefs}>:-D$<JOIN:${compileDefs},;-D>>" ${cxxStandardFlag} -fsyntax-only -Wno-pragma-once-outside-header -nobuiltininc
+            OUTPUT ${unitSource} ${outputFiles} ${moduleFiles}
+            COMMENT "Generating reflection data for the headers of ${targetName}"
+            DEPENDS ${headerPaths} rwc ${ARG_IMPORTS}
+            ${dependencyArguments}
+            COMMAND_EXPAND_LISTS
+            )
+        target_sources(${generatedTargetName} PRIVATE ${unitSource} ${outputFiles})
+        if (ARG_MODULE)
+            _rosewood_add_module_interfaces(${targetName} ${moduleFiles})
+        endif()
+        return()
+    endif()
+
     foreach(headerFile ${headerFiles})
         get_filename_component(filnenameWE ${headerFile} NAME_WE)
 
         set(outputCXXFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.h)
-        set(outputJsonFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.json)
+        set(outputDatabaseFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.rwdb)
+        set(depFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.d)
+        set(repositoryFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.ids)
+        set(layoutArguments)
+        set(outputSourceFile)
+        if (ARG_SPLIT)
+            set(outputSourceFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cpp)
+            set(layoutArguments -s ${outputSourceFile})
+        endif()
+        set(declarationFiles)
+        if (ARG_DECLARATION_HEADERS)
+            list(APPEND layoutArguments -declarations ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata)
+            _rosewood_declaration_outputs(declarationFiles ${generatedTargetName} ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata)
+        endif()
+        set(outputModuleFile)
+        if (ARG_MODULE)
+            set(outputModuleFile ${CMAKE_CURRENT_BINARY_DIR}/${filnenameWE}.metadata.cppm)
+            list(APPEND layoutArguments -module-interface ${outputModuleFile})
+        endif()
+        _rosewood_dependency_arguments(dependencyArguments ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} ${depFile})
 
         add_custom_command(
-            COMMAND rwc ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} -n ${filnenameWE} -o ${outputCXXFile} -j ${outputJsonFile} -- -x c++ "$<$<BOOL:${includeDirs}>:-I$<JOIN:${includeDirs},;-I>>" "$<$<BOOL:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES}>:-I$<JOIN:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES},;-I>>" "$<$<BOOL:${compileDefs}>:-D$<JOIN:${compileDefs},;-D>>" ${cxxStandardFlag} -fsyntax-only -Wno-pragma-once-outside-header -nobuiltininc
-            OUTPUT ${outputCXXFile} ${outputJsonFile}
+            COMMAND rwc ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} -n ${filnenameWE} -o ${outputCXXFile} -j ${outputDatabaseFile} -d ${depFile} -i ${repositoryFile} ${layoutArguments} ${importArguments} -- -x c++ "$<$<BOOL:${includeDirs}>:-I$<JOIN:${includeDirs},;-I>>" "$<$<BOOL:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES}>:-I$<JOIN:${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES},;-I>>" "$<$<BOOL:${compileDefs}>:-D$<JOIN:${compileDefs},;-D>>" ${cxxStandardFlag} -fsyntax-only -Wno-pragma-once-outside-header -nobuiltininc
+            OUTPUT ${outputCXXFile} ${outputDatabaseFile} ${repositoryFile} ${outputSourceFile} ${outputModuleFile} ${declarationFiles}
             COMMENT "Generating reflection data for ${headerFile}"
-            DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} rwc
-            IMPLICIT_DEPENDS CXX ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile}
+            DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/${headerFile} rwc ${ARG_IMPORTS}
+            ${dependencyArguments}
             COMMAND_EXPAND_LISTS
             )
 
-        set (forcedDependencyFile ${CMAKE_CURRENT_BINARY_DIR}/__${filnenameWE}_forceinclude.cpp)
-        file(GENERATE OUTPUT ${forcedDependencyFile} CONTENT "#include \"${outputCXXFile}\"")
-        target_sources(${generatedTargetName} PRIVATE ${outputCXXFile} ${outputJsonFile} ${forcedDependencyFile})
+        if (ARG_SPLIT)
+            target_sources(${generatedTargetName} PRIVATE ${outputCXXFile} ${outputDatabaseFile} ${outputSourceFile})
+        else()
+            set (forcedDependencyFile ${CMAKE_CURRENT_BINARY_DIR}/__${filnenameWE}_forceinclude.cpp)
+            file(GENERATE OUTPUT ${forcedDependencyFile} CONTENT "#include \"${outputCXXFile}\"")
+            target_sources(${generatedTargetName} PRIVATE ${outputCXXFile} ${outputDatabaseFile} ${forcedDependencyFile})
+        endif()
+        if (ARG_MODULE)
+            _rosewood_add_module_interfaces(${targetName} ${outputModuleFile})
+        endif()
     endforeach()
 endfunction()
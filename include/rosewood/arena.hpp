@@ -0,0 +1,459 @@
+#pragma once
+
+#include <rosewood/rosewood.hpp>
+#include <rosewood/runtime.hpp>
+#include <rosewood/database.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace rosewood {
+
+    /**
+     * The records of an ArenaModel. They are laid out like those of a reflection database, see rosewood::db, but point into the
+     * generated descriptors for names and calls instead of into a string table.
+     */
+    namespace arena {
+        using MethodThunk = void (*)(const void *descriptor, void *object, void *retValAddr, void **args);
+        using FieldThunk = void (*)(const void *descriptor, void *object, void *from, bool move);
+
+        /**
+         * Declaration 0 is the module. The nested declarations and the members of a declaration are stored next to each other and
+         * sorted by name, overloads keep their declaration order.
+         */
+        struct DeclarationRecord {
+            std::string_view name;
+            db::DeclarationKind kind;
+            std::uint32_t parent;
+            std::uint32_t firstDeclaration;
+            std::uint32_t declarationCount;
+            std::uint32_t firstMember;
+            std::uint32_t memberCount;
+        };
+
+        struct MemberRecord {
+            std::string_view name;
+            // the MethodDeclaration or FieldDeclaration in the tables of the descriptor, null for enumerators
+            const void *descriptor;
+            MethodThunk invoke;
+            FieldThunk assign;
+            // the value of enumerators
+            std::int64_t value;
+            db::MemberKind kind;
+            std::uint32_t flags;
+            std::uint32_t parent;
+        };
+    }
+
+    class ArenaModel;
+
+    class ArenaDeclaration;
+
+    /**
+     * @brief ArenaMember is a method, field or enumerator of an ArenaModel. Like DatabaseMember, it's two words wide and only valid
+     * as long as the model. A default constructed view stands for nothing, see operator bool.
+     */
+    class ArenaMember {
+    public:
+        ArenaMember() = default;
+        ArenaMember(const ArenaModel *Model, std::uint32_t Index) : model(Model), index(Index) {}
+
+        explicit operator bool() const noexcept { return model && index != db::none; }
+
+        std::string_view getName() const noexcept;
+        db::MemberKind getKind() const noexcept;
+        std::int64_t getValue() const noexcept;
+        bool isConst() const noexcept;
+        bool isNoexcept() const noexcept;
+        ArenaDeclaration parent() const noexcept;
+
+        /**
+         * @brief call is just as unchecked as DMethod::call
+         * @throw const_corectness_error when calling a non const method on a const object
+         */
+        void call(const void *object, void *retValAddr, void **args) const;
+        void call(void *object, void *retValAddr, void **args) const;
+
+        void assign_copy(void *object, void *from) const;
+        void assign_move(void *object, void *from) const;
+
+    private:
+        const arena::MemberRecord &record() const noexcept;
+
+        const ArenaModel *model = nullptr;
+        std::uint32_t index = db::none;
+    };
+
+    class ArenaDeclaration {
+    public:
+        ArenaDeclaration() = default;
+        ArenaDeclaration(const ArenaModel *Model, std::uint32_t Index) : model(Model), index(Index) {}
+
+        explicit operator bool() const noexcept { return model && index != db::none; }
+
+        std::string_view getName() const noexcept;
+        db::DeclarationKind getKind() const noexcept;
+        ArenaDeclaration parent() const noexcept;
+
+        detail::IndexRange<ArenaDeclaration, ArenaModel> declarations() const noexcept;
+        detail::IndexRange<ArenaMember, ArenaModel> members() const noexcept;
+
+        /**
+         * @brief getDeclaration finds a nested declaration by name with a binary search. Qualified names, such as `outer::Class`,
+         * are looked up one part at a time.
+         */
+        ArenaDeclaration getDeclaration(std::string_view name) const noexcept;
+        /**
+         * @return the first overload of the member called name
+         */
+        ArenaMember getMember(std::string_view name) const noexcept;
+        /**
+         * @return every overload of the member called name, empty if there's none
+         */
+        detail::IndexRange<ArenaMember, ArenaModel> getMembers(std::string_view name) const noexcept;
+
+    private:
+        const arena::DeclarationRecord &record() const noexcept;
+
+        const ArenaModel *model = nullptr;
+        std::uint32_t index = db::none;
+    };
+
+    /**
+     * @brief The ArenaModel class is a runtime model of a module that, unlike DNamespaceWrapper, makes a single allocation: every
+     * declaration and every member of the module is a record of one arena, sized at compile time from the descriptors. Records refer
+     * to each other by index, nested declarations and members are contiguous ranges of them.
+     * Enumerators are members of their enum, methods and fields those of their class. Constructors aren't part of the model.
+     */
+    class ArenaModel {
+    public:
+        template <typename ModuleDescriptor>
+        explicit ArenaModel(const ModuleDescriptor &);
+
+        ArenaModel(ArenaModel &&other) noexcept = default;
+        ArenaModel &operator=(ArenaModel &&other) noexcept = default;
+        ArenaModel(const ArenaModel &) = delete;
+        ArenaModel &operator=(const ArenaModel &) = delete;
+
+        ArenaDeclaration getModule() const noexcept { return ArenaDeclaration(this, 0); }
+        /**
+         * @brief getDeclaration looks up a declaration by its qualified name, see ArenaDeclaration::getDeclaration
+         */
+        ArenaDeclaration getDeclaration(std::string_view qualifiedName) const noexcept { return getModule().getDeclaration(qualifiedName); }
+
+        /**
+         * @return the size in bytes of the arena
+         */
+        std::size_t size() const noexcept { return arenaSize; }
+
+    private:
+        friend class ArenaMember;
+        friend class ArenaDeclaration;
+
+        using fill_function = void (*)(ArenaModel &model, std::uint32_t index);
+
+        template <typename Descriptor>
+        static void fill(ArenaModel &model, std::uint32_t index);
+        template <typename Descriptor>
+        void fillNested(std::uint32_t index);
+        template <typename Descriptor>
+        void fillMembers(std::uint32_t index);
+
+        std::unique_ptr<unsigned char[]> storage;
+        std::size_t arenaSize = 0;
+        arena::DeclarationRecord *declarationRecords = nullptr;
+        arena::MemberRecord *memberRecords = nullptr;
+        // where the next nested declarations and members go while the model is built
+        std::uint32_t nextDeclaration = 0;
+        std::uint32_t nextMember = 0;
+    };
+
+    namespace detail {
+        template <typename MethodDescriptor>
+        void invoke_method(const void *descriptor, void *object, void *retValAddr, void **args) {
+            static_cast<const MethodDescriptor*>(descriptor)->invoke(object, retValAddr, args);
+        }
+
+        template <typename FieldDescriptor>
+        void assign_field(const void *descriptor, void *object, void *from, bool move) {
+            const auto field = static_cast<const FieldDescriptor*>(descriptor);
+            if (move) {
+                field->assign_move(object, from);
+            } else {
+                field->assign_copy(object, from);
+            }
+        }
+
+        template <typename Tuple>
+        struct descriptor_counts;
+
+        template <typename ...Descriptors>
+        struct descriptor_counts<std::tuple<Descriptors...>> {
+            template <typename Counter>
+            static constexpr std::size_t sum([[maybe_unused]] Counter counter) {
+                return (std::size_t(0) + ... + counter(static_cast<Descriptors*>(nullptr)));
+            }
+        };
+
+        // the counts the records of a model are sized with: those of the declarations nested in a descriptor and of its own members,
+        // then those of the descriptor and everything nested in it
+        template <typename Descriptor>
+        constexpr std::size_t nested_count() {
+            if constexpr (is_enum_descriptor<Descriptor>) {
+                return 0;
+            } else if constexpr (is_class_descriptor<Descriptor>) {
+                return std::tuple_size_v<typename Descriptor::enums> + std::tuple_size_v<typename Descriptor::classes>;
+            } else {
+                return std::tuple_size_v<typename Descriptor::namespaces> + std::tuple_size_v<typename Descriptor::enums> + std::tuple_size_v<typename Descriptor::classes>;
+            }
+        }
+
+        template <typename Descriptor>
+        constexpr std::size_t member_count() {
+            if constexpr (is_enum_descriptor<Descriptor>) {
+                return std::tuple_size_v<std::remove_const_t<decltype(Descriptor::enumerators)>>;
+            } else if constexpr (is_class_descriptor<Descriptor>) {
+                return std::tuple_size_v<std::remove_const_t<decltype(Descriptor::methods)>> + std::tuple_size_v<std::remove_const_t<decltype(Descriptor::fields)>>;
+            } else {
+                return 0;
+            }
+        }
+
+        template <typename Descriptor>
+        constexpr std::size_t declarations_in() {
+            // the declaration itself and everything nested in it
+            constexpr auto count = [] (auto *nested) { return declarations_in<std::remove_pointer_t<decltype(nested)>>(); };
+            if constexpr (is_enum_descriptor<Descriptor>) {
+                return 1;
+            } else if constexpr (is_class_descriptor<Descriptor>) {
+                return 1 + descriptor_counts<typename Descriptor::enums>::sum(count) + descriptor_counts<typename Descriptor::classes>::sum(count);
+            } else {
+                return 1 + descriptor_counts<typename Descriptor::namespaces>::sum(count) + descriptor_counts<typename Descriptor::enums>::sum(count)
+                         + descriptor_counts<typename Descriptor::classes>::sum(count);
+            }
+        }
+
+        template <typename Descriptor>
+        constexpr std::size_t members_in() {
+            constexpr auto count = [] (auto *nested) { return members_in<std::remove_pointer_t<decltype(nested)>>(); };
+            if constexpr (is_enum_descriptor<Descriptor>) {
+                return member_count<Descriptor>();
+            } else if constexpr (is_class_descriptor<Descriptor>) {
+                return member_count<Descriptor>() + descriptor_counts<typename Descriptor::enums>::sum(count) + descriptor_counts<typename Descriptor::classes>::sum(count);
+            } else {
+                return descriptor_counts<typename Descriptor::namespaces>::sum(count) + descriptor_counts<typename Descriptor::enums>::sum(count)
+                     + descriptor_counts<typename Descriptor::classes>::sum(count);
+            }
+        }
+    }
+
+    template <typename ModuleDescriptor>
+    ArenaModel::ArenaModel(const ModuleDescriptor &) {
+        constexpr std::size_t declarationCount = detail::declarations_in<ModuleDescriptor>();
+        constexpr std::size_t memberCount = detail::members_in<ModuleDescriptor>();
+        static_assert(declarationCount < db::none && memberCount < db::none, "too many declarations for an ArenaModel");
+
+        constexpr std::size_t membersOffset = (declarationCount * sizeof(arena::DeclarationRecord) + alignof(arena::MemberRecord) - 1) / alignof(arena::MemberRecord) * alignof(arena::MemberRecord);
+        arenaSize = membersOffset + memberCount * sizeof(arena::MemberRecord);
+        storage.reset(new unsigned char[arenaSize]);
+        declarationRecords = std::uninitialized_value_construct_n(reinterpret_cast<arena::DeclarationRecord*>(storage.get()), declarationCount) - declarationCount;
+        memberRecords = std::uninitialized_value_construct_n(reinterpret_cast<arena::MemberRecord*>(storage.get() + membersOffset), memberCount) - memberCount;
+
+        declarationRecords[0] = {ModuleDescriptor::name, db::DeclarationKind::Module, db::none, 0, 0, 0, 0};
+        nextDeclaration = 1;
+        fill<ModuleDescriptor>(*this, 0);
+    }
+
+    template <typename Descriptor>
+    void ArenaModel::fill(ArenaModel &model, std::uint32_t index) {
+        model.fillMembers<Descriptor>(index);
+        model.fillNested<Descriptor>(index);
+    }
+
+    template <typename Descriptor>
+    void ArenaModel::fillNested(std::uint32_t index) {
+        constexpr std::size_t count = detail::nested_count<Descriptor>();
+        if constexpr (count > 0) {
+            struct Nested {
+                std::string_view name;
+                db::DeclarationKind kind;
+                fill_function fill;
+            };
+            std::array<Nested, count> nested;
+            std::size_t added = 0;
+            auto add = [&nested, &added] ([[maybe_unused]] db::DeclarationKind kind, auto... descriptors) {
+                ((nested[added++] = Nested{decltype(descriptors)::name, kind, &ArenaModel::fill<decltype(descriptors)>}), ...);
+            };
+            if constexpr (!detail::is_class_descriptor<Descriptor>) {
+                std::apply([&add] (auto... namespaces) { add(db::DeclarationKind::Namespace, namespaces...); }, typename Descriptor::namespaces{});
+            }
+            std::apply([&add] (auto... enums) { add(db::DeclarationKind::Enum, enums...); }, typename Descriptor::enums{});
+            std::apply([&add] (auto... classes) { add(db::DeclarationKind::Class, classes...); }, typename Descriptor::classes{});
+            std::sort(nested.begin(), nested.end(), [] (const Nested &lhs, const Nested &rhs) { return lhs.name < rhs.name; });
+
+            // the whole range is placed before any of it is filled, which places the declarations nested in it further on
+            const std::uint32_t first = nextDeclaration;
+            nextDeclaration += static_cast<std::uint32_t>(count);
+            declarationRecords[index].firstDeclaration = first;
+            declarationRecords[index].declarationCount = static_cast<std::uint32_t>(count);
+            for (std::uint32_t idx(0); idx < count; ++idx) {
+                declarationRecords[first + idx] = {nested[idx].name, nested[idx].kind, index, 0, 0, 0, 0};
+            }
+            for (std::uint32_t idx(0); idx < count; ++idx) {
+                nested[idx].fill(*this, first + idx);
+            }
+        }
+    }
+
+    template <typename Descriptor>
+    void ArenaModel::fillMembers(std::uint32_t index) {
+        constexpr std::size_t count = detail::member_count<Descriptor>();
+        if constexpr (count > 0) {
+            const std::uint32_t first = nextMember;
+            nextMember += static_cast<std::uint32_t>(count);
+            declarationRecords[index].firstMember = first;
+            declarationRecords[index].memberCount = static_cast<std::uint32_t>(count);
+
+            auto member = memberRecords + first;
+            if constexpr (detail::is_enum_descriptor<Descriptor>) {
+                for (const auto &enumerator: Descriptor::enumerators) {
+                    *member++ = {enumerator.name, nullptr, nullptr, nullptr, static_cast<std::int64_t>(enumerator.value), db::MemberKind::Enumerator, 0, index};
+                }
+            } else {
+                // value holds the declaration order of methods and fields until they are sorted, which keeps overloads in that order
+                std::int64_t position = 0;
+                std::apply([&member, &position, index] (const auto &...methods) {
+                    ((*member++ = {methods.name, &methods, &detail::invoke_method<std::decay_t<decltype(methods)>>, nullptr, position++, db::MemberKind::Method,
+                                   (methods.is_const ? db::Const : 0u) | (methods.is_noexcept ? db::Noexcept : 0u), index}), ...);
+                }, Descriptor::methods);
+                std::apply([&member, &position, index] (const auto &...fields) {
+                    ((*member++ = {fields.name, &fields, nullptr, &detail::assign_field<std::decay_t<decltype(fields)>>, position++, db::MemberKind::Field, 0, index}), ...);
+                }, Descriptor::fields);
+            }
+            // std::sort rather than std::stable_sort, which would allocate
+            std::sort(memberRecords + first, memberRecords + first + count, [] (const arena::MemberRecord &lhs, const arena::MemberRecord &rhs) {
+                return lhs.name < rhs.name || (lhs.name == rhs.name && lhs.value < rhs.value);
+            });
+            if constexpr (!detail::is_enum_descriptor<Descriptor>) {
+                for (auto record = memberRecords + first; record != member; ++record) {
+                    record->value = 0;
+                }
+            }
+        }
+    }
+
+    inline const arena::MemberRecord &ArenaMember::record() const noexcept {
+        return model->memberRecords[index];
+    }
+
+    inline std::string_view ArenaMember::getName() const noexcept {
+        return record().name;
+    }
+
+    inline db::MemberKind ArenaMember::getKind() const noexcept {
+        return record().kind;
+    }
+
+    inline std::int64_t ArenaMember::getValue() const noexcept {
+        return record().value;
+    }
+
+    inline bool ArenaMember::isConst() const noexcept {
+        return record().flags & db::Const;
+    }
+
+    inline bool ArenaMember::isNoexcept() const noexcept {
+        return record().flags & db::Noexcept;
+    }
+
+    inline ArenaDeclaration ArenaMember::parent() const noexcept {
+        return ArenaDeclaration(model, record().parent);
+    }
+
+    inline void ArenaMember::call(const void *object, void *retValAddr, void **args) const {
+        if (!isConst()) {
+            throw const_corectness_error("non const method called on const object");
+        }
+        record().invoke(record().descriptor, const_cast<void*>(object), retValAddr, args);
+    }
+
+    inline void ArenaMember::call(void *object, void *retValAddr, void **args) const {
+        record().invoke(record().descriptor, object, retValAddr, args);
+    }
+
+    inline void ArenaMember::assign_copy(void *object, void *from) const {
+        record().assign(record().descriptor, object, from, false);
+    }
+
+    inline void ArenaMember::assign_move(void *object, void *from) const {
+        record().assign(record().descriptor, object, from, true);
+    }
+
+    inline const arena::DeclarationRecord &ArenaDeclaration::record() const noexcept {
+        return model->declarationRecords[index];
+    }
+
+    inline std::string_view ArenaDeclaration::getName() const noexcept {
+        return record().name;
+    }
+
+    inline db::DeclarationKind ArenaDeclaration::getKind() const noexcept {
+        return record().kind;
+    }
+
+    inline ArenaDeclaration ArenaDeclaration::parent() const noexcept {
+        return ArenaDeclaration(model, record().parent);
+    }
+
+    inline detail::IndexRange<ArenaDeclaration, ArenaModel> ArenaDeclaration::declarations() const noexcept {
+        return detail::IndexRange<ArenaDeclaration, ArenaModel>(model, record().firstDeclaration, record().declarationCount);
+    }
+
+    inline detail::IndexRange<ArenaMember, ArenaModel> ArenaDeclaration::members() const noexcept {
+        return detail::IndexRange<ArenaMember, ArenaModel>(model, record().firstMember, record().memberCount);
+    }
+
+    inline ArenaDeclaration ArenaDeclaration::getDeclaration(std::string_view name) const noexcept {
+        ArenaDeclaration context = *this;
+        for (;;) {
+            const auto separator = name.find("::");
+            const auto part = name.substr(0, separator);
+            const auto range = context.declarations();
+            const auto found = std::lower_bound(range.begin(), range.end(), part, [] (const ArenaDeclaration &declaration, std::string_view value) {
+                return declaration.getName() < value;
+            });
+            if (found == range.end() || (*found).getName() != part) {
+                return ArenaDeclaration();
+            }
+            if (separator == std::string_view::npos) {
+                return *found;
+            }
+            context = *found;
+            name.remove_prefix(separator + 2);
+        }
+    }
+
+    inline detail::IndexRange<ArenaMember, ArenaModel> ArenaDeclaration::getMembers(std::string_view name) const noexcept {
+        const auto range = members();
+        const auto first = std::lower_bound(range.begin(), range.end(), name, [] (const ArenaMember &member, std::string_view value) {
+            return member.getName() < value;
+        });
+        const auto last = std::upper_bound(first, range.end(), name, [] (std::string_view value, const ArenaMember &member) {
+            return value < member.getName();
+        });
+        return detail::IndexRange<ArenaMember, ArenaModel>(model, record().firstMember + static_cast<std::uint32_t>(first - range.begin()), static_cast<std::uint32_t>(last - first));
+    }
+
+    inline ArenaMember ArenaDeclaration::getMember(std::string_view name) const noexcept {
+        const auto overloads = getMembers(name);
+        return overloads.empty() ? ArenaMember() : overloads[0];
+    }
+
+}
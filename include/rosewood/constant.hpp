@@ -0,0 +1,443 @@
+#pragma once
+
+#include <rosewood/rosewood.hpp>
+#include <rosewood/runtime.hpp>
+#include <rosewood/database.hpp>
+#include <rosewood/arena.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+
+namespace rosewood {
+
+    /**
+     * The records of a ConstantModel. They are laid out like those of an ArenaModel, but in the order of the descriptors rather than
+     * sorted by name: names are looked up in the member tables rwc generates for every namespace, class and enum instead.
+     */
+    namespace constant {
+        // the position of the declaration called name among those nested in a declaration, or that of its first member called name. db::none if there is none
+        using LookupThunk = std::uint32_t (*)(std::string_view name);
+        using ValueThunk = std::int64_t (*)(const void *enumerator);
+
+        /**
+         * Declaration 0 is the module. The nested declarations and the members of a declaration are stored next to each other, in
+         * the order of the tuples of its descriptor.
+         */
+        struct DeclarationRecord {
+            std::string_view name;
+            db::DeclarationKind kind = db::DeclarationKind::Module;
+            std::uint32_t parent = db::none;
+            std::uint32_t firstDeclaration = 0;
+            std::uint32_t declarationCount = 0;
+            std::uint32_t firstMember = 0;
+            std::uint32_t memberCount = 0;
+            // null for enums
+            LookupThunk findDeclaration = nullptr;
+            // null for namespaces
+            LookupThunk findMember = nullptr;
+        };
+
+        struct MemberRecord {
+            // the name in the tables of the descriptor, which only the generated source can see into when rwc puts them out of line
+            const std::string_view *name = nullptr;
+            // the MethodDeclaration, FieldDeclaration or Enumerator in the tables of the descriptor
+            const void *descriptor = nullptr;
+            arena::MethodThunk invoke = nullptr;
+            arena::FieldThunk assign = nullptr;
+            ValueThunk value = nullptr;
+            db::MemberKind kind = db::MemberKind::Method;
+            std::uint32_t flags = 0;
+            std::uint32_t parent = db::none;
+        };
+    }
+
+    class ConstantModel;
+
+    class ConstantDeclaration;
+
+    /**
+     * @brief ConstantMember is a method, field or enumerator of a ConstantModel, the counterpart of ArenaMember
+     */
+    class ConstantMember {
+    public:
+        ConstantMember() = default;
+        ConstantMember(const ConstantModel *Model, std::uint32_t Index) : model(Model), index(Index) {}
+
+        explicit operator bool() const noexcept { return model && index != db::none; }
+
+        std::string_view getName() const noexcept;
+        db::MemberKind getKind() const noexcept;
+        std::int64_t getValue() const noexcept;
+        bool isConst() const noexcept;
+        bool isNoexcept() const noexcept;
+        ConstantDeclaration parent() const noexcept;
+
+        /**
+         * @brief call is just as unchecked as DMethod::call
+         * @throw const_corectness_error when calling a non const method on a const object
+         */
+        void call(const void *object, void *retValAddr, void **args) const;
+        void call(void *object, void *retValAddr, void **args) const;
+
+        void assign_copy(void *object, void *from) const;
+        void assign_move(void *object, void *from) const;
+
+    private:
+        const constant::MemberRecord &record() const noexcept;
+
+        const ConstantModel *model = nullptr;
+        std::uint32_t index = db::none;
+    };
+
+    /**
+     * @brief ConstantDeclaration is a namespace, class or enum of a ConstantModel, the counterpart of ArenaDeclaration
+     */
+    class ConstantDeclaration {
+    public:
+        ConstantDeclaration() = default;
+        ConstantDeclaration(const ConstantModel *Model, std::uint32_t Index) : model(Model), index(Index) {}
+
+        explicit operator bool() const noexcept { return model && index != db::none; }
+
+        std::string_view getName() const noexcept;
+        db::DeclarationKind getKind() const noexcept;
+        ConstantDeclaration parent() const noexcept;
+
+        detail::IndexRange<ConstantDeclaration, ConstantModel> declarations() const noexcept;
+        detail::IndexRange<ConstantMember, ConstantModel> members() const noexcept;
+
+        /**
+         * @brief getDeclaration finds a nested declaration by name with a single hash table lookup. Qualified names, such as
+         * `outer::Class`, are looked up one part at a time.
+         */
+        ConstantDeclaration getDeclaration(std::string_view name) const noexcept;
+        /**
+         * @return the first overload of the member called name
+         */
+        ConstantMember getMember(std::string_view name) const noexcept;
+        /**
+         * @return every overload of the member called name, empty if there's none
+         */
+        detail::IndexRange<ConstantMember, ConstantModel> getMembers(std::string_view name) const noexcept;
+
+    private:
+        const constant::DeclarationRecord &record() const noexcept;
+
+        const ConstantModel *model = nullptr;
+        std::uint32_t index = db::none;
+    };
+
+    /**
+     * @brief The ConstantModel class is a runtime model that costs nothing to use: its records are computed by the compiler from the
+     * descriptors and end up in read-only data, with function pointers for calls and field assignments. There's no constructor to
+     * run, no allocation and no static initialization. Get the model of a module with constant_model rather than constructing one.
+     * Like in an ArenaModel, enumerators are members of their enum, methods and fields those of their class.
+     */
+    class ConstantModel {
+    public:
+        constexpr ConstantModel(const constant::DeclarationRecord *Declarations, const constant::MemberRecord *Members) noexcept
+            :declarationRecords(Declarations),
+             memberRecords(Members) {}
+
+        ConstantModel(const ConstantModel &) = delete;
+        ConstantModel &operator=(const ConstantModel &) = delete;
+
+        ConstantDeclaration getModule() const noexcept { return ConstantDeclaration(this, 0); }
+        /**
+         * @brief getDeclaration looks up a declaration by its qualified name, see ConstantDeclaration::getDeclaration
+         */
+        ConstantDeclaration getDeclaration(std::string_view qualifiedName) const noexcept { return getModule().getDeclaration(qualifiedName); }
+
+    private:
+        friend class ConstantMember;
+        friend class ConstantDeclaration;
+
+        const constant::DeclarationRecord *declarationRecords;
+        const constant::MemberRecord *memberRecords;
+    };
+
+    namespace detail {
+        template <typename Descriptor>
+        std::uint32_t find_nested_declaration(std::string_view name) {
+            const MemberSlot *slot = Descriptor::member_table.find(name);
+            if (!slot) {
+                return db::none;
+            }
+            // nested declarations are stored namespaces first, then enums and classes
+            std::uint32_t namespaces = 0;
+            if constexpr (!is_class_descriptor<Descriptor>) {
+                namespaces = static_cast<std::uint32_t>(std::tuple_size_v<typename Descriptor::namespaces>);
+            }
+            const auto enums = static_cast<std::uint32_t>(std::tuple_size_v<typename Descriptor::enums>);
+            switch (slot->kind) {
+            case MemberKind::Namespace:
+                return slot->index;
+            case MemberKind::Enum:
+                return namespaces + slot->index;
+            case MemberKind::Class:
+                return namespaces + enums + slot->index;
+            default:
+                return db::none;
+            }
+        }
+
+        template <typename Descriptor>
+        std::uint32_t find_first_member(std::string_view name) {
+            if constexpr (is_enum_descriptor<Descriptor>) {
+                const std::uint32_t index = Descriptor{}.enumerator_index(name);
+                return index != no_enumerator ? index : db::none;
+            } else {
+                const MemberSlot *slot = Descriptor::member_table.find(name);
+                if (!slot) {
+                    return db::none;
+                }
+                // methods come first, then fields
+                switch (slot->kind) {
+                case MemberKind::Method:
+                    return slot->index;
+                case MemberKind::Field:
+                    return static_cast<std::uint32_t>(std::tuple_size_v<std::remove_const_t<decltype(Descriptor::methods)>>) + slot->index;
+                default:
+                    return db::none;
+                }
+            }
+        }
+
+        template <typename EnumeratorType>
+        std::int64_t enumerator_value(const void *enumerator) {
+            return static_cast<std::int64_t>(static_cast<const EnumeratorType*>(enumerator)->value);
+        }
+
+        /**
+         * @brief constant_records builds the records of a ConstantModel at compile time. Only the addresses of the tables of the descriptors
+         * are taken, never their contents, which out of line tables don't let the compiler see
+         */
+        template <std::size_t DeclarationCount, std::size_t MemberCount>
+        struct constant_records {
+            std::array<constant::DeclarationRecord, DeclarationCount> declarations{};
+            std::array<constant::MemberRecord, MemberCount> members{};
+            std::uint32_t nextDeclaration = 1;
+            std::uint32_t nextMember = 0;
+
+            template <typename Descriptor>
+            constexpr void fill(std::uint32_t index) {
+                fillMembers<Descriptor>(index);
+                fillNested<Descriptor>(index);
+            }
+
+            template <typename Descriptor>
+            constexpr void place(std::uint32_t position, std::uint32_t parent, db::DeclarationKind kind) {
+                auto &record = declarations[position];
+                record.name = Descriptor::name;
+                record.kind = kind;
+                record.parent = parent;
+                if constexpr (!is_enum_descriptor<Descriptor>) {
+                    record.findDeclaration = &find_nested_declaration<Descriptor>;
+                }
+                if constexpr (is_enum_descriptor<Descriptor> || is_class_descriptor<Descriptor>) {
+                    record.findMember = &find_first_member<Descriptor>;
+                }
+            }
+
+            template <typename Descriptor>
+            constexpr void fillNested(std::uint32_t index) {
+                constexpr std::size_t count = nested_count<Descriptor>();
+                if constexpr (count > 0) {
+                    // the whole range is placed before any of it is filled, which places the declarations nested in it further on
+                    const std::uint32_t first = nextDeclaration;
+                    nextDeclaration += static_cast<std::uint32_t>(count);
+                    declarations[index].firstDeclaration = first;
+                    declarations[index].declarationCount = static_cast<std::uint32_t>(count);
+
+                    std::uint32_t position = first;
+                    auto placeAll = [this, &position, index] (db::DeclarationKind kind, auto tuple) {
+                        std::apply([this, &position, index, kind] (auto ...descriptors) {
+                            (this->template place<decltype(descriptors)>(position++, index, kind), ...);
+                        }, tuple);
+                    };
+                    auto fillAll = [this, &position] (auto tuple) {
+                        std::apply([this, &position] (auto ...descriptors) {
+                            (this->template fill<decltype(descriptors)>(position++), ...);
+                        }, tuple);
+                    };
+                    if constexpr (!is_class_descriptor<Descriptor>) {
+                        placeAll(db::DeclarationKind::Namespace, typename Descriptor::namespaces{});
+                    }
+                    placeAll(db::DeclarationKind::Enum, typename Descriptor::enums{});
+                    placeAll(db::DeclarationKind::Class, typename Descriptor::classes{});
+                    position = first;
+                    if constexpr (!is_class_descriptor<Descriptor>) {
+                        fillAll(typename Descriptor::namespaces{});
+                    }
+                    fillAll(typename Descriptor::enums{});
+                    fillAll(typename Descriptor::classes{});
+                }
+            }
+
+            template <typename Descriptor>
+            constexpr void fillMembers(std::uint32_t index) {
+                constexpr std::size_t count = member_count<Descriptor>();
+                if constexpr (count > 0) {
+                    const std::uint32_t first = nextMember;
+                    nextMember += static_cast<std::uint32_t>(count);
+                    declarations[index].firstMember = first;
+                    declarations[index].memberCount = static_cast<std::uint32_t>(count);
+
+                    std::uint32_t position = first;
+                    if constexpr (is_enum_descriptor<Descriptor>) {
+                        for (std::size_t idx(0); idx < count; ++idx) {
+                            const auto &enumerator = Descriptor::enumerators[idx];
+                            members[position++] = {&enumerator.name, &enumerator, nullptr, nullptr, &enumerator_value<typename Descriptor::enumerator_type>,
+                                                   db::MemberKind::Enumerator, 0, index};
+                        }
+                    } else {
+                        std::apply([this, &position, index] (const auto &...methods) {
+                            ((members[position++] = {&methods.name, &methods, &invoke_method<std::decay_t<decltype(methods)>>, nullptr, nullptr, db::MemberKind::Method,
+                                                     (std::decay_t<decltype(methods)>::is_const ? db::Const : 0u) | (std::decay_t<decltype(methods)>::is_noexcept ? db::Noexcept : 0u), index}), ...);
+                        }, Descriptor::methods);
+                        std::apply([this, &position, index] (const auto &...fields) {
+                            ((members[position++] = {&fields.name, &fields, nullptr, &assign_field<std::decay_t<decltype(fields)>>, nullptr, db::MemberKind::Field, 0, index}), ...);
+                        }, Descriptor::fields);
+                    }
+                }
+            }
+        };
+
+        template <typename ModuleDescriptor>
+        constexpr auto build_constant_records() {
+            constexpr std::size_t declarationCount = declarations_in<ModuleDescriptor>();
+            constexpr std::size_t memberCount = members_in<ModuleDescriptor>();
+            static_assert(declarationCount < db::none && memberCount < db::none, "too many declarations for a ConstantModel");
+
+            constant_records<declarationCount, memberCount> records{};
+            records.declarations[0].name = ModuleDescriptor::name;
+            records.declarations[0].findDeclaration = &find_nested_declaration<ModuleDescriptor>;
+            records.template fill<ModuleDescriptor>(0);
+            return records;
+        }
+
+        template <typename ModuleDescriptor>
+        struct constant_model_records {
+            static constexpr auto records = build_constant_records<ModuleDescriptor>();
+        };
+    }
+
+    /**
+     * @brief constant_model is the ConstantModel of the module described by ModuleDescriptor, e.g. constant_model<meta_Module>
+     */
+    template <typename ModuleDescriptor>
+    inline constexpr ConstantModel constant_model(detail::constant_model_records<ModuleDescriptor>::records.declarations.data(),
+                                                   detail::constant_model_records<ModuleDescriptor>::records.members.data());
+
+    inline const constant::MemberRecord &ConstantMember::record() const noexcept {
+        return model->memberRecords[index];
+    }
+
+    inline std::string_view ConstantMember::getName() const noexcept {
+        return *record().name;
+    }
+
+    inline db::MemberKind ConstantMember::getKind() const noexcept {
+        return record().kind;
+    }
+
+    inline std::int64_t ConstantMember::getValue() const noexcept {
+        return record().value ? record().value(record().descriptor) : 0;
+    }
+
+    inline bool ConstantMember::isConst() const noexcept {
+        return record().flags & db::Const;
+    }
+
+    inline bool ConstantMember::isNoexcept() const noexcept {
+        return record().flags & db::Noexcept;
+    }
+
+    inline ConstantDeclaration ConstantMember::parent() const noexcept {
+        return ConstantDeclaration(model, record().parent);
+    }
+
+    inline void ConstantMember::call(const void *object, void *retValAddr, void **args) const {
+        if (!isConst()) {
+            throw const_corectness_error("non const method called on const object");
+        }
+        record().invoke(record().descriptor, const_cast<void*>(object), retValAddr, args);
+    }
+
+    inline void ConstantMember::call(void *object, void *retValAddr, void **args) const {
+        record().invoke(record().descriptor, object, retValAddr, args);
+    }
+
+    inline void ConstantMember::assign_copy(void *object, void *from) const {
+        record().assign(record().descriptor, object, from, false);
+    }
+
+    inline void ConstantMember::assign_move(void *object, void *from) const {
+        record().assign(record().descriptor, object, from, true);
+    }
+
+    inline const constant::DeclarationRecord &ConstantDeclaration::record() const noexcept {
+        return model->declarationRecords[index];
+    }
+
+    inline std::string_view ConstantDeclaration::getName() const noexcept {
+        return record().name;
+    }
+
+    inline db::DeclarationKind ConstantDeclaration::getKind() const noexcept {
+        return record().kind;
+    }
+
+    inline ConstantDeclaration ConstantDeclaration::parent() const noexcept {
+        return ConstantDeclaration(model, record().parent);
+    }
+
+    inline detail::IndexRange<ConstantDeclaration, ConstantModel> ConstantDeclaration::declarations() const noexcept {
+        return detail::IndexRange<ConstantDeclaration, ConstantModel>(model, record().firstDeclaration, record().declarationCount);
+    }
+
+    inline detail::IndexRange<ConstantMember, ConstantModel> ConstantDeclaration::members() const noexcept {
+        return detail::IndexRange<ConstantMember, ConstantModel>(model, record().firstMember, record().memberCount);
+    }
+
+    inline ConstantDeclaration ConstantDeclaration::getDeclaration(std::string_view name) const noexcept {
+        std::uint32_t context = index;
+        for (;;) {
+            const auto &contextRecord = model->declarationRecords[context];
+            const auto separator = name.find("::");
+            const std::uint32_t position = contextRecord.findDeclaration ? contextRecord.findDeclaration(name.substr(0, separator)) : db::none;
+            if (position == db::none) {
+                return ConstantDeclaration();
+            }
+            context = contextRecord.firstDeclaration + position;
+            if (separator == std::string_view::npos) {
+                return ConstantDeclaration(model, context);
+            }
+            name.remove_prefix(separator + 2);
+        }
+    }
+
+    inline detail::IndexRange<ConstantMember, ConstantModel> ConstantDeclaration::getMembers(std::string_view name) const noexcept {
+        const std::uint32_t position = record().findMember ? record().findMember(name) : db::none;
+        if (position == db::none) {
+            return detail::IndexRange<ConstantMember, ConstantModel>(model, record().firstMember, 0);
+        }
+        // overloads follow the first one
+        const std::uint32_t first = record().firstMember + position;
+        const std::uint32_t end = record().firstMember + record().memberCount;
+        std::uint32_t last = first + 1;
+        while (last < end && *model->memberRecords[last].name == name) {
+            ++last;
+        }
+        return detail::IndexRange<ConstantMember, ConstantModel>(model, first, last - first);
+    }
+
+    inline ConstantMember ConstantDeclaration::getMember(std::string_view name) const noexcept {
+        const auto overloads = getMembers(name);
+        return overloads.empty() ? ConstantMember() : overloads[0];
+    }
+
+}
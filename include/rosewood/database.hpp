@@ -0,0 +1,486 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <algorithm>
+
+namespace rosewood {
+
+    /**
+     * The on-disk layout of a reflection database, as written by rwc -j. Everything lives in a single block with no pointers, only
+     * indices into the flat arrays below and offsets into one string table, so a database is used right where it's mapped.
+     * All integers are in the byte order of the machine that wrote the file, FileHeader::byteOrder tells whether that's ours.
+     */
+    namespace db {
+        inline constexpr char magic[8] = {'R', 'W', 'D', 'B', '\0', '\r', '\n', '\x1a'};
+        inline constexpr std::uint32_t version = 1;
+        inline constexpr std::uint32_t byteOrder = 0x01020304;
+        // stands for a missing index, such as the parent of the root declaration or the type of a namespace
+        inline constexpr std::uint32_t none = 0xffffffff;
+
+        enum class DeclarationKind : std::uint32_t {
+            Module,
+            Namespace,
+            Class,
+            Enum
+        };
+
+        enum class MemberKind : std::uint32_t {
+            Field,
+            Method,
+            Constructor,
+            Enumerator
+        };
+
+        enum MemberFlags : std::uint32_t {
+            Const = 1,
+            Noexcept = 2
+        };
+
+        enum ParameterFlags : std::uint32_t {
+            HasDefaultArgument = 1
+        };
+
+        // strings are NUL terminated in the table on top of being sized, for the sake of C APIs
+        struct StringRef {
+            std::uint32_t offset;
+            std::uint32_t size;
+        };
+
+        struct Section {
+            // from the start of the file, aligned to 8 bytes
+            std::uint32_t offset;
+            // in records, or in bytes for the string table
+            std::uint32_t count;
+        };
+
+        struct FileHeader {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byteOrder;
+            Section declarations;
+            Section members;
+            Section parameters;
+            Section types;
+            Section strings;
+        };
+
+        /**
+         * Declaration 0 is the module. The nested declarations and the members of a declaration are stored next to each other and
+         * sorted by name, overloads keep their declaration order.
+         */
+        struct DeclarationRecord {
+            DeclarationKind kind;
+            StringRef name;
+            StringRef qualifiedName;
+            std::uint32_t parent;
+            // the class itself for classes, the underlying type for enums, none otherwise
+            std::uint32_t type;
+            std::uint32_t firstDeclaration;
+            std::uint32_t declarationCount;
+            std::uint32_t firstMember;
+            std::uint32_t memberCount;
+        };
+
+        struct MemberRecord {
+            // the value of enumerators, the offset in bytes of fields
+            std::int64_t value;
+            MemberKind kind;
+            std::uint32_t flags;
+            StringRef name;
+            std::uint32_t parent;
+            // the type of fields, the return type of methods, none otherwise
+            std::uint32_t type;
+            std::uint32_t firstParameter;
+            std::uint32_t parameterCount;
+        };
+
+        struct ParameterRecord {
+            StringRef name;
+            std::uint32_t type;
+            std::uint32_t flags;
+        };
+
+        // types are interned, two records never have the same names
+        struct TypeRecord {
+            StringRef name;
+            StringRef canonicalName;
+            StringRef atomicName;
+        };
+
+        static_assert(sizeof(FileHeader) == 56);
+        static_assert(sizeof(DeclarationRecord) == 44);
+        static_assert(sizeof(MemberRecord) == 40);
+        static_assert(sizeof(ParameterRecord) == 16);
+        static_assert(sizeof(TypeRecord) == 24);
+    }
+
+    class database_error : public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    class Database;
+
+    namespace detail {
+        /**
+         * A random access range over consecutive records of Owner, a database, an ArenaModel or a ConstantModel, seen through View.
+         */
+        template <typename View, typename Owner>
+        class IndexRange {
+        public:
+            class iterator {
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = View;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = View;
+
+                iterator() = default;
+                iterator(const Owner *Db, std::uint32_t Index) : db(Db), index(Index) {}
+
+                View operator*() const noexcept { return View(db, index); }
+                View operator[](difference_type offset) const noexcept { return View(db, static_cast<std::uint32_t>(index + offset)); }
+
+                iterator &operator++() noexcept { ++index; return *this; }
+                iterator operator++(int) noexcept { auto copy = *this; ++index; return copy; }
+                iterator &operator--() noexcept { --index; return *this; }
+                iterator operator--(int) noexcept { auto copy = *this; --index; return copy; }
+                iterator &operator+=(difference_type offset) noexcept { index = static_cast<std::uint32_t>(index + offset); return *this; }
+                iterator &operator-=(difference_type offset) noexcept { index = static_cast<std::uint32_t>(index - offset); return *this; }
+                iterator operator+(difference_type offset) const noexcept { auto copy = *this; return copy += offset; }
+                iterator operator-(difference_type offset) const noexcept { auto copy = *this; return copy -= offset; }
+                difference_type operator-(const iterator &other) const noexcept { return static_cast<difference_type>(index) - static_cast<difference_type>(other.index); }
+
+                bool operator==(const iterator &other) const noexcept { return index == other.index; }
+                bool operator!=(const iterator &other) const noexcept { return index != other.index; }
+                bool operator<(const iterator &other) const noexcept { return index < other.index; }
+
+            private:
+                const Owner *db = nullptr;
+                std::uint32_t index = 0;
+            };
+
+            IndexRange(const Owner *Db, std::uint32_t First, std::uint32_t Count)
+                :db(Db),
+                 first(First),
+                 count(Count) {}
+
+            iterator begin() const noexcept { return iterator(db, first); }
+            iterator end() const noexcept { return iterator(db, first + count); }
+            std::size_t size() const noexcept { return count; }
+            bool empty() const noexcept { return count == 0; }
+            View operator[](std::size_t idx) const noexcept { return View(db, static_cast<std::uint32_t>(first + idx)); }
+
+        private:
+            const Owner *db;
+            std::uint32_t first;
+            std::uint32_t count;
+        };
+
+        template <typename View>
+        using DatabaseRange = IndexRange<View, Database>;
+    }
+
+    /**
+     * @brief DatabaseType is the database counterpart of DType. Like every view into a Database, it's two words wide and only valid
+     * as long as the database. A default constructed view stands for nothing, see operator bool.
+     */
+    class DatabaseType {
+    public:
+        DatabaseType() = default;
+        DatabaseType(const Database *Db, std::uint32_t Index) : db(Db), index(Index) {}
+
+        explicit operator bool() const noexcept { return db && index != db::none; }
+
+        std::string_view getName() const noexcept;
+        std::string_view getCanonicalName() const noexcept;
+        std::string_view getAtomicName() const noexcept;
+
+    private:
+        const db::TypeRecord &record() const noexcept;
+
+        const Database *db = nullptr;
+        std::uint32_t index = db::none;
+    };
+
+    class DatabaseParameter {
+    public:
+        DatabaseParameter() = default;
+        DatabaseParameter(const Database *Db, std::uint32_t Index) : db(Db), index(Index) {}
+
+        explicit operator bool() const noexcept { return db && index != db::none; }
+
+        std::string_view getName() const noexcept;
+        DatabaseType getType() const noexcept;
+        bool hasDefaultArgument() const noexcept;
+
+    private:
+        const db::ParameterRecord &record() const noexcept;
+
+        const Database *db = nullptr;
+        std::uint32_t index = db::none;
+    };
+
+    class DatabaseDeclaration;
+
+    class DatabaseMember {
+    public:
+        DatabaseMember() = default;
+        DatabaseMember(const Database *Db, std::uint32_t Index) : db(Db), index(Index) {}
+
+        explicit operator bool() const noexcept { return db && index != db::none; }
+
+        std::string_view getName() const noexcept;
+        db::MemberKind getKind() const noexcept;
+        DatabaseType getType() const noexcept;
+        std::int64_t getValue() const noexcept;
+        bool isConst() const noexcept;
+        bool isNoexcept() const noexcept;
+        detail::DatabaseRange<DatabaseParameter> parameters() const noexcept;
+        DatabaseDeclaration parent() const noexcept;
+
+    private:
+        const db::MemberRecord &record() const noexcept;
+
+        const Database *db = nullptr;
+        std::uint32_t index = db::none;
+    };
+
+    class DatabaseDeclaration {
+    public:
+        DatabaseDeclaration() = default;
+        DatabaseDeclaration(const Database *Db, std::uint32_t Index) : db(Db), index(Index) {}
+
+        explicit operator bool() const noexcept { return db && index != db::none; }
+
+        std::string_view getName() const noexcept;
+        std::string_view getQualifiedName() const noexcept;
+        db::DeclarationKind getKind() const noexcept;
+        DatabaseType getType() const noexcept;
+        DatabaseDeclaration parent() const noexcept;
+
+        detail::DatabaseRange<DatabaseDeclaration> declarations() const noexcept;
+        detail::DatabaseRange<DatabaseMember> members() const noexcept;
+
+        /**
+         * @brief getDeclaration finds a nested declaration by name with a binary search. Qualified names, such as `outer::Class`,
+         * are looked up one part at a time.
+         */
+        DatabaseDeclaration getDeclaration(std::string_view name) const noexcept;
+        /**
+         * @return the first overload of the member called name
+         */
+        DatabaseMember getMember(std::string_view name) const noexcept;
+        /**
+         * @return every overload of the member called name, empty if there's none
+         */
+        detail::DatabaseRange<DatabaseMember> getMembers(std::string_view name) const noexcept;
+
+    private:
+        const db::DeclarationRecord &record() const noexcept;
+
+        const Database *db = nullptr;
+        std::uint32_t index = db::none;
+    };
+
+    /**
+     * @brief The Database class gives access to a reflection database written by rwc -j. Opening one maps the file into memory and
+     * checks its header, nothing is parsed or copied: every query goes straight to the mapped records and none of them allocates.
+     * The records themselves are trusted, like any other generated code.
+     */
+    class Database {
+    public:
+        /**
+         * @brief maps the file at path
+         * @throw database_error if the file can't be mapped or isn't a database this runtime understands
+         */
+        explicit Database(const std::string &path);
+        /**
+         * @brief uses a database that's already in memory, such as one embedded in a binary. data must stay valid for as long as the
+         * database is used and be aligned to 8 bytes
+         * @throw database_error if data isn't a database this runtime understands
+         */
+        Database(const void *data, std::size_t size);
+
+        Database(Database &&other) noexcept;
+        Database &operator=(Database &&other) noexcept;
+        Database(const Database &) = delete;
+        Database &operator=(const Database &) = delete;
+        ~Database();
+
+        DatabaseDeclaration getModule() const noexcept { return DatabaseDeclaration(this, 0); }
+        /**
+         * @brief getDeclaration looks up a declaration by its qualified name, see DatabaseDeclaration::getDeclaration
+         */
+        DatabaseDeclaration getDeclaration(std::string_view qualifiedName) const noexcept { return getModule().getDeclaration(qualifiedName); }
+
+        std::size_t size() const noexcept { return dataSize; }
+
+    private:
+        friend class DatabaseType;
+        friend class DatabaseParameter;
+        friend class DatabaseMember;
+        friend class DatabaseDeclaration;
+
+        void validate();
+        void unmap() noexcept;
+
+        template <typename Record>
+        const Record &at(const db::Section &section, std::uint32_t index) const noexcept {
+            return reinterpret_cast<const Record*>(data + section.offset)[index];
+        }
+
+        const db::FileHeader &header() const noexcept { return *reinterpret_cast<const db::FileHeader*>(data); }
+
+        std::string_view string(const db::StringRef &ref) const noexcept {
+            return std::string_view(reinterpret_cast<const char*>(data + header().strings.offset + ref.offset), ref.size);
+        }
+
+        const unsigned char *data = nullptr;
+        std::size_t dataSize = 0;
+        // whether data was mapped by this instance and needs to be unmapped
+        bool mapped = false;
+    };
+
+    inline const db::TypeRecord &DatabaseType::record() const noexcept {
+        return db->at<db::TypeRecord>(db->header().types, index);
+    }
+
+    inline std::string_view DatabaseType::getName() const noexcept {
+        return db->string(record().name);
+    }
+
+    inline std::string_view DatabaseType::getCanonicalName() const noexcept {
+        return db->string(record().canonicalName);
+    }
+
+    inline std::string_view DatabaseType::getAtomicName() const noexcept {
+        return db->string(record().atomicName);
+    }
+
+    inline const db::ParameterRecord &DatabaseParameter::record() const noexcept {
+        return db->at<db::ParameterRecord>(db->header().parameters, index);
+    }
+
+    inline std::string_view DatabaseParameter::getName() const noexcept {
+        return db->string(record().name);
+    }
+
+    inline DatabaseType DatabaseParameter::getType() const noexcept {
+        return DatabaseType(db, record().type);
+    }
+
+    inline bool DatabaseParameter::hasDefaultArgument() const noexcept {
+        return record().flags & db::HasDefaultArgument;
+    }
+
+    inline const db::MemberRecord &DatabaseMember::record() const noexcept {
+        return db->at<db::MemberRecord>(db->header().members, index);
+    }
+
+    inline std::string_view DatabaseMember::getName() const noexcept {
+        return db->string(record().name);
+    }
+
+    inline db::MemberKind DatabaseMember::getKind() const noexcept {
+        return record().kind;
+    }
+
+    inline DatabaseType DatabaseMember::getType() const noexcept {
+        return DatabaseType(db, record().type);
+    }
+
+    inline std::int64_t DatabaseMember::getValue() const noexcept {
+        return record().value;
+    }
+
+    inline bool DatabaseMember::isConst() const noexcept {
+        return record().flags & db::Const;
+    }
+
+    inline bool DatabaseMember::isNoexcept() const noexcept {
+        return record().flags & db::Noexcept;
+    }
+
+    inline detail::DatabaseRange<DatabaseParameter> DatabaseMember::parameters() const noexcept {
+        return detail::DatabaseRange<DatabaseParameter>(db, record().firstParameter, record().parameterCount);
+    }
+
+    inline DatabaseDeclaration DatabaseMember::parent() const noexcept {
+        return DatabaseDeclaration(db, record().parent);
+    }
+
+    inline const db::DeclarationRecord &DatabaseDeclaration::record() const noexcept {
+        return db->at<db::DeclarationRecord>(db->header().declarations, index);
+    }
+
+    inline std::string_view DatabaseDeclaration::getName() const noexcept {
+        return db->string(record().name);
+    }
+
+    inline std::string_view DatabaseDeclaration::getQualifiedName() const noexcept {
+        return db->string(record().qualifiedName);
+    }
+
+    inline db::DeclarationKind DatabaseDeclaration::getKind() const noexcept {
+        return record().kind;
+    }
+
+    inline DatabaseType DatabaseDeclaration::getType() const noexcept {
+        return DatabaseType(db, record().type);
+    }
+
+    inline DatabaseDeclaration DatabaseDeclaration::parent() const noexcept {
+        return DatabaseDeclaration(db, record().parent);
+    }
+
+    inline detail::DatabaseRange<DatabaseDeclaration> DatabaseDeclaration::declarations() const noexcept {
+        return detail::DatabaseRange<DatabaseDeclaration>(db, record().firstDeclaration, record().declarationCount);
+    }
+
+    inline detail::DatabaseRange<DatabaseMember> DatabaseDeclaration::members() const noexcept {
+        return detail::DatabaseRange<DatabaseMember>(db, record().firstMember, record().memberCount);
+    }
+
+    inline DatabaseDeclaration DatabaseDeclaration::getDeclaration(std::string_view name) const noexcept {
+        DatabaseDeclaration context = *this;
+        for (;;) {
+            const auto separator = name.find("::");
+            const auto part = name.substr(0, separator);
+            const auto range = context.declarations();
+            const auto found = std::lower_bound(range.begin(), range.end(), part, [] (const DatabaseDeclaration &declaration, std::string_view value) {
+                return declaration.getName() < value;
+            });
+            if (found == range.end() || (*found).getName() != part) {
+                return DatabaseDeclaration();
+            }
+            if (separator == std::string_view::npos) {
+                return *found;
+            }
+            context = *found;
+            name.remove_prefix(separator + 2);
+        }
+    }
+
+    inline detail::DatabaseRange<DatabaseMember> DatabaseDeclaration::getMembers(std::string_view name) const noexcept {
+        const auto range = members();
+        const auto first = std::lower_bound(range.begin(), range.end(), name, [] (const DatabaseMember &member, std::string_view value) {
+            return member.getName() < value;
+        });
+        const auto last = std::upper_bound(first, range.end(), name, [] (std::string_view value, const DatabaseMember &member) {
+            return value < member.getName();
+        });
+        return detail::DatabaseRange<DatabaseMember>(db, record().firstMember + static_cast<std::uint32_t>(first - range.begin()), static_cast<std::uint32_t>(last - first));
+    }
+
+    inline DatabaseMember DatabaseDeclaration::getMember(std::string_view name) const noexcept {
+        const auto overloads = getMembers(name);
+        return overloads.empty() ? DatabaseMember() : overloads[0];
+    }
+
+}
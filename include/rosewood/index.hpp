@@ -3,9 +3,13 @@
 #include "rosewood.hpp"
 #include "runtime.hpp"
 
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <string_view>
 #include <tuple>
+#include <vector>
 
 namespace rosewood {
 
@@ -13,70 +17,172 @@ namespace rosewood {
     public:
 
     };
+
+    /**
+     * @brief QualifiedNameTable maps fully qualified names, such as `a::b::Widget::resize`, to declarations in a single flat hash table,
+     * so finding one takes one probe however deeply it's nested. Names are hashed with hash_name.
+     */
+    class QualifiedNameTable {
+    public:
+        enum class Hashing {
+            // open addressing with linear probing, in a table at most half full
+            Linear,
+            // a perfect hash, built with PerfectHash: every lookup probes exactly one slot. Building it takes longer
+            Perfect
+        };
+
+        /**
+         * @brief add registers declaration under qualifiedName. The first declaration added under a name keeps it
+         */
+        void add(std::string_view qualifiedName, const Declaration *declaration);
+
+        /**
+         * @brief build lays the table out once every declaration was added, lookups find nothing before. If no perfect hash fits, which only
+         * happens to names with the same 64 bit hash, the table falls back to linear probing
+         */
+        void build(Hashing hashing);
+
+        const Declaration *find(const hashed_name &qualifiedName) const noexcept;
+
+        /**
+         * @return the number of distinct names in the table
+         */
+        std::size_t size() const noexcept { return entries.size(); }
+        bool isPerfect() const noexcept { return !displacements.empty(); }
+
+    private:
+        struct Entry {
+            std::uint64_t hash;
+            // in names
+            std::uint32_t offset;
+            std::uint32_t length;
+            const Declaration *declaration;
+        };
+
+        static constexpr std::uint32_t emptySlot = ~std::uint32_t(0);
+
+        std::string_view nameOf(const Entry &entry) const noexcept { return std::string_view(names.data() + entry.offset, entry.length); }
+        bool matches(std::uint32_t entry, std::uint64_t hash, std::string_view qualifiedName) const noexcept;
+
+        // every name added, back to back
+        std::string names;
+        std::vector<Entry> entries;
+        // the entry of every slot, emptySlot for the empty ones
+        std::vector<std::uint32_t> slots;
+        // those of the perfect hash, empty with linear probing
+        std::vector<std::uint32_t> displacements;
+    };
+
 /**
- *  @class StaticIndex is a utlity that makes searching for declarations easier.
- * Declarations are essentially stored in a tree
- * so this class flattens that structure and maintains a bunch of data structures for fast lookups (has tables?)
+ * @class StaticIndex is a utlity that makes searching for declarations easier.
+ * Declarations are essentially stored in a tree, this class builds that tree once for all of the modules it indexes and flattens it
+ * into a QualifiedNameTable: every namespace, class, enum, method, field and enumerator is found by its fully qualified name with a
+ * single lookup. Top level declarations of different modules that have the same name go to the module listed first.
  */
-template <typename ...WrappedTypes>
+template <typename ...Modules>
 class StaticIndex : public Index {
 public:
-    StaticIndex() {
-        init_toplevel_lookups();
+    explicit StaticIndex(QualifiedNameTable::Hashing hashing = QualifiedNameTable::Hashing::Linear) {
+        std::string qualifiedName;
+        (addModule<Modules>(qualifiedName), ...);
+        table.build(hashing);
     }
 
+    using Index::getDeclaration;
+
+    /**
+     * @param name the fully qualified name of a declaration, without a leading `::`
+     */
     const Declaration *getDeclaration(std::string_view name) const noexcept final {
-        if (auto res = toplevel_declarations.find(name); res != toplevel_declarations.end()) {
-            return res->second.get();
-        }
-        return nullptr;
+        return table.find(name);
     }
 
-private:
-
-    template<unsigned tIdx = 0>
-    void init_toplevel_lookups() {
-        using tuple_type = std::tuple<WrappedTypes...>;
-
-        if constexpr (tIdx < std::tuple_size<tuple_type>::value) {
-            using current_type = typename std::tuple_element<tIdx, tuple_type>::type;
-            using enums_type = typename current_type::enums;
-            using classes_type = typename current_type::classes;
-            using namespaces_type = typename current_type::namespaces;
-            constexpr enums_type enums;
-            constexpr classes_type classes;
-            constexpr namespaces_type namespaces;
+    const Declaration *getDeclaration(const hashed_name &name) const noexcept final {
+        return table.find(name);
+    }
 
-            std::apply([this] (auto &&...enums) {
-                ((toplevel_declarations[enums.name] = std::move(std::make_unique<DEnumWrapper>((enums, this)))), ...);
-            }, enums);
+    const QualifiedNameTable &names() const noexcept {
+        return table;
+    }
 
-            std::apply([this] (auto &&...classes) {
-                ((toplevel_declarations[classes.name] = std::move(std::make_unique<DClassWrapper>((classes, this)))), ...);
-            }, classes);
+private:
+    template <typename Module>
+    void addModule(std::string &qualifiedName) {
+        auto addTopLevel = [this, &qualifiedName] (auto descriptor, auto make) {
+            auto &declaration = toplevel_declarations.emplace_back(make(descriptor, this));
+            qualifiedName.assign(descriptor.name);
+            table.add(qualifiedName, declaration.get());
+            addNested<decltype(descriptor)>(declaration.get(), qualifiedName);
+        };
+        std::apply([&addTopLevel] (auto ...namespaces) {
+            (addTopLevel(namespaces, [] (auto descriptor, const DeclarationContext *parent) { return makeNamespace(descriptor, parent); }), ...);
+        }, typename Module::namespaces{});
+        std::apply([&addTopLevel] (auto ...enums) {
+            (addTopLevel(enums, [] (auto descriptor, const DeclarationContext *parent) { return makeEnum(descriptor, parent); }), ...);
+        }, typename Module::enums{});
+        std::apply([&addTopLevel] (auto ...classes) {
+            (addTopLevel(classes, [] (auto descriptor, const DeclarationContext *parent) { return makeClass(descriptor, parent); }), ...);
+        }, typename Module::classes{});
+    }
 
-            std::apply([this] (auto &&...nmspcs) {
-                ((toplevel_declarations[nmspcs.name] = rosewood::makeNamespace(nmspcs, this)), ...);
-            }, namespaces);
+    /**
+     * @brief addNested adds what's declared in declaration, described by Descriptor, under qualifiedName, its own qualified name
+     */
+    template <typename Descriptor>
+    void addNested(const Declaration *declaration, std::string &qualifiedName) {
+        const DeclarationContext *context = nullptr;
+        if constexpr (detail::is_enum_descriptor<Descriptor>) {
+            context = declaration->asEnum();
+        } else if constexpr (detail::is_class_descriptor<Descriptor>) {
+            context = declaration->asClass();
+        } else {
+            context = declaration->asNamespace();
+        }
+        if (!context) {
+            return;
+        }
 
-            init_toplevel_lookups<tIdx+1>();
+        const std::size_t prefixLength = qualifiedName.size();
+        auto add = [this, context, &qualifiedName, prefixLength] (std::string_view name) {
+            qualifiedName.resize(prefixLength);
+            qualifiedName.append("::").append(name);
+            const Declaration *nested = context->getDeclaration(name);
+            if (nested) {
+                table.add(qualifiedName, nested);
+            }
+            return nested;
+        };
+        auto addAll = [this, &add, &qualifiedName] (auto descriptors) {
+            std::apply([this, &add, &qualifiedName] (auto ...nested) {
+                ([this, &add, &qualifiedName] (auto descriptor) {
+                    if (const Declaration *added = add(descriptor.name)) {
+                        addNested<decltype(descriptor)>(added, qualifiedName);
+                    }
+                }(nested), ...);
+            }, descriptors);
+        };
+
+        if constexpr (detail::is_enum_descriptor<Descriptor>) {
+            for (const auto &enumerator: Descriptor::enumerators) {
+                add(enumerator.name);
+            }
+        } else {
+            if constexpr (detail::is_class_descriptor<Descriptor>) {
+                // the runtime model finds the first overload of methods, the others are chained to it
+                std::apply([&add] (const auto &...methods) { (add(methods.name), ...); }, Descriptor::methods);
+                std::apply([&add] (const auto &...fields) { (add(fields.name), ...); }, Descriptor::fields);
+            } else {
+                addAll(typename Descriptor::namespaces{});
+            }
+            addAll(typename Descriptor::enums{});
+            addAll(typename Descriptor::classes{});
         }
+        qualifiedName.resize(prefixLength);
     }
 
-    // for starteres, all declarations need to be stored somewhere.
-    // of course, all members of this tuple will have their nested types contained within so for us storing them is enough
-    // static const std::tuple<WrappedTypes...> toplevel_types;
-    // using topleveltypes_t = typename rosewood::arguments_wrapper<rosewood::DNamespaceWrapper, std::tuple<>, std::tuple<WrappedTypes...>>::type;
-
-    // topleveltypes_t topleveltypes;
-    // when an entity is searched for by it's full name than nothing beats a hash table
-    std::unordered_map<std::string_view, std::unique_ptr<rosewood::Declaration>> toplevel_declarations;
+    // the trees of the modules, which the table points into
+    std::vector<std::unique_ptr<Declaration>> toplevel_declarations;
+    QualifiedNameTable table;
 };
 
-// template <typename ...WrappedTypes>
-// const std::tuple<WrappedTypes...> StaticIndex<WrappedTypes...>::toplevel_types;
-
-// template <typename ...WrappedTypes>
-// const std::unordered_map<std::string_view, const rosewood::DMetaDecl*> StaticIndex<WrappedTypes...>::name_lookup = StaticIndex<WrappedTypes...>::init_name_lookup();
-
 }
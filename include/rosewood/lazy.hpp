@@ -0,0 +1,232 @@
+#pragma once
+
+#include <rosewood/rosewood.hpp>
+#include <rosewood/runtime.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <tuple>
+
+namespace rosewood {
+
+    /**
+     * The lazy runtime model implements the same interfaces as DNamespaceWrapper and ClassWrapper, but only creates the declarations
+     * of a context the first time they are looked up. Constructing the model of a module costs nothing more than its own slots.
+     * Each child has a slot of its own that's filled once: concurrent first lookups may each build the child, the first one to
+     * publish it wins and the others throw theirs away. Lookups by name never lock, those by name_id read the name back from
+     * NameTable::global(), under its shared lock.
+     */
+    namespace detail {
+        /**
+         * @brief once returns the declaration of slot, publishing the one make builds if there's none yet
+         */
+        template <typename MakeT>
+        const Declaration *once(std::atomic<Declaration*> &slot, MakeT make) {
+            if (Declaration *existing = slot.load(std::memory_order_acquire)) {
+                return existing;
+            }
+            std::unique_ptr<Declaration> created = make();
+            Declaration *expected = nullptr;
+            if (slot.compare_exchange_strong(expected, created.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return created.release();
+            }
+            return expected;
+        }
+
+        template <std::size_t Size>
+        class lazy_slots {
+        public:
+            lazy_slots() = default;
+            lazy_slots(const lazy_slots&) = delete;
+            lazy_slots &operator=(const lazy_slots&) = delete;
+
+            ~lazy_slots() {
+                for (auto &slot: slots) {
+                    delete slot.load(std::memory_order_relaxed);
+                }
+            }
+
+            std::atomic<Declaration*> &operator[](std::size_t idx) noexcept {
+                return slots[idx];
+            }
+
+        private:
+            std::array<std::atomic<Declaration*>, Size> slots{};
+        };
+    }
+
+    template <typename MetaNamespace>
+    class LazyNamespaceWrapper;
+
+    template <typename MetaClass>
+    class LazyClassWrapper;
+
+    template <typename MetaEnum>
+    class LazyEnumWrapper;
+
+    template<typename MetaEnum>
+    class LazyEnumWrapper : public DEnum {
+        using descriptor = MetaEnum;
+    public:
+        LazyEnumWrapper(const MetaEnum &, const DeclarationContext *parent)
+            : DEnum(parent) {}
+
+        inline std::string_view getName() const noexcept final {
+            return descriptor::name;
+        }
+
+        using DEnum::getDeclaration;
+
+        const Declaration *getDeclaration(std::string_view name) const noexcept final {
+            const auto index = MetaEnum{}.enumerator_index(name);
+            if (index == no_enumerator) {
+                return nullptr;
+            }
+            return detail::once(enumerators[index], [this, index] () -> std::unique_ptr<Declaration> {
+                return std::make_unique<DEnumeratorWrapper<typename descriptor::enumerator_type>>(descriptor::enumerators[index], this);
+            });
+        }
+
+    private:
+        mutable detail::lazy_slots<std::tuple_size_v<std::remove_const_t<decltype(descriptor::enumerators)>>> enumerators;
+    };
+
+    template <typename MetaClass>
+    class LazyClassWrapper : public Class {
+    public:
+        using descriptor = MetaClass;
+
+        LazyClassWrapper(const MetaClass &, const DeclarationContext *parent)
+            : Class(parent) {}
+
+        inline std::string_view getName() const noexcept final {
+            return descriptor::name;
+        }
+
+        using Class::getDeclaration;
+
+        const Declaration *getDeclaration(std::string_view name) const noexcept final {
+            return getDeclaration(hashed_name(name));
+        }
+
+        const Declaration *getDeclaration(const hashed_name &name) const noexcept final {
+            const auto slot = descriptor::member_table.slot_of(name);
+            if (slot == descriptor::member_table.npos) {
+                return nullptr;
+            }
+            return detail::once(declarations[slot], [this, slot] { return materialize(slot); });
+        }
+
+    private:
+        std::unique_ptr<Declaration> materialize(std::size_t slot) const {
+            const MemberSlot &member = descriptor::member_table.slots[slot];
+            std::unique_ptr<Declaration> result;
+            switch (member.kind) {
+            case MemberKind::Method: {
+                std::unique_ptr<DMethod> first;
+                std::apply([this, &member, &first] (const auto &...methods) {
+                    ([this, &member, &first] (const auto &method) {
+                        if (method.name != member.name) {
+                            return;
+                        }
+                        if (first) {
+                            first->pushOverload(makeUniqueMethod(method, this));
+                        } else {
+                            first = makeUniqueMethod(method, this);
+                        }
+                    }(methods), ...);
+                }, descriptor::methods);
+                result = std::move(first);
+            } break;
+            case MemberKind::Field:
+                std::apply([this, &member, &result] (const auto &...fields) {
+                    ((!result && fields.name == member.name ? static_cast<void>(result = makeField(fields, this)) : static_cast<void>(0)), ...);
+                }, descriptor::fields);
+                break;
+            case MemberKind::Enum:
+                std::apply([this, &member, &result] (auto ...enums) {
+                    ((!result && enums.name == member.name ? static_cast<void>(result = std::make_unique<LazyEnumWrapper<decltype(enums)>>(enums, this)) : static_cast<void>(0)), ...);
+                }, typename descriptor::enums{});
+                break;
+            case MemberKind::Class:
+                std::apply([this, &member, &result] (auto ...classes) {
+                    ((!result && classes.name == member.name ? static_cast<void>(result = std::make_unique<LazyClassWrapper<decltype(classes)>>(classes, this)) : static_cast<void>(0)), ...);
+                }, typename descriptor::classes{});
+                break;
+            case MemberKind::Namespace:
+            case MemberKind::None:
+                break;
+            }
+            return result;
+        }
+
+        mutable detail::lazy_slots<descriptor::member_table.slots.size()> declarations;
+    };
+
+    template <typename MetaNamespace>
+    class LazyNamespaceWrapper : public DNamespace {
+        using descriptor = MetaNamespace;
+    public:
+        LazyNamespaceWrapper(const MetaNamespace &, const DeclarationContext *parent)
+            : DNamespace(parent) {}
+
+        inline std::string_view getName() const noexcept final {
+            return descriptor::name;
+        }
+
+        using DNamespace::getDeclaration;
+
+        const Declaration *getDeclaration(std::string_view name) const noexcept final {
+            return getDeclaration(hashed_name(name));
+        }
+
+        const Declaration *getDeclaration(const hashed_name &name) const noexcept final {
+            const auto slot = descriptor::member_table.slot_of(name);
+            if (slot == descriptor::member_table.npos) {
+                return nullptr;
+            }
+            return detail::once(declarations[slot], [this, slot] { return materialize(slot); });
+        }
+
+    private:
+        std::unique_ptr<Declaration> materialize(std::size_t slot) const {
+            const MemberSlot &member = descriptor::member_table.slots[slot];
+            std::unique_ptr<Declaration> result;
+            auto make = [this, &member, &result] (auto descriptorTuple, auto wrap) {
+                std::apply([this, &member, &result, wrap] (auto ...descriptors) {
+                    [[maybe_unused]] std::uint32_t index = 0;
+                    ((index++ == member.index ? static_cast<void>(result = wrap(descriptors, this)) : static_cast<void>(0)), ...);
+                }, descriptorTuple);
+            };
+            switch (member.kind) {
+            case MemberKind::Namespace:
+                make(typename descriptor::namespaces{}, [] (auto nested, const DeclarationContext *parent) -> std::unique_ptr<Declaration> {
+                    return std::make_unique<LazyNamespaceWrapper<decltype(nested)>>(nested, parent);
+                });
+                break;
+            case MemberKind::Enum:
+                make(typename descriptor::enums{}, [] (auto nested, const DeclarationContext *parent) -> std::unique_ptr<Declaration> {
+                    return std::make_unique<LazyEnumWrapper<decltype(nested)>>(nested, parent);
+                });
+                break;
+            case MemberKind::Class:
+                make(typename descriptor::classes{}, [] (auto nested, const DeclarationContext *parent) -> std::unique_ptr<Declaration> {
+                    return std::make_unique<LazyClassWrapper<decltype(nested)>>(nested, parent);
+                });
+                break;
+            default:
+                break;
+            }
+            return result;
+        }
+
+        mutable detail::lazy_slots<descriptor::member_table.slots.size()> declarations;
+    };
+
+    template <typename T>
+    LazyNamespaceWrapper(const T&, const DeclarationContext*) -> LazyNamespaceWrapper<T>;
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <rosewood/rosewood.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace rosewood {
+
+    /**
+     * @brief name_id is the dense integer a NameTable gives a name, starting from 0 in the order names are interned
+     */
+    enum class name_id : std::uint32_t {};
+
+    /**
+     * @brief no_name is the id of the names that were never interned
+     */
+    inline constexpr name_id no_name = name_id(~std::uint32_t(0));
+
+    /**
+     * @brief NameTable interns names: every distinct name gets a name_id of its own, for as long as the table lives. Declarations of the
+     * runtime model intern their names in the global table the first time their ids are asked for, never while the model is built,
+     * which makes comparing and looking names up a matter of integers. Resolve a name once with intern and reuse its id on hot paths.
+     * Tables are safe to use from several threads.
+     */
+    class NameTable {
+    public:
+        NameTable() = default;
+        NameTable(const NameTable&) = delete;
+        NameTable &operator=(const NameTable&) = delete;
+
+        /**
+         * @brief global is the table of the process, the one the runtime model interns names in
+         */
+        static NameTable &global();
+
+        /**
+         * @return the id of name, which is given one if it has none yet. The table keeps a copy of the name
+         */
+        name_id intern(const hashed_name &name);
+        name_id intern(std::string_view name) { return intern(hashed_name(name)); }
+
+        /**
+         * @return the id of name, no_name if it was never interned. Unlike intern, this never grows the table
+         */
+        name_id find(const hashed_name &name) const noexcept;
+        name_id find(std::string_view name) const noexcept { return find(hashed_name(name)); }
+
+        /**
+         * @return the name of id along with its hash, an empty name for no_name and for the ids the table didn't give
+         */
+        hashed_name name(name_id id) const noexcept;
+
+        std::size_t size() const noexcept;
+
+    private:
+        struct Entry {
+            std::string name;
+            std::uint64_t hash;
+        };
+
+        mutable std::shared_mutex mutex;
+        // by id. The entries of a deque stay where they are, so the names and keys that refer to them do too
+        std::deque<Entry> names;
+        std::unordered_map<hashed_name, name_id, hashed_name::hasher> ids;
+    };
+
+}
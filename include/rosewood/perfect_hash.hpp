@@ -0,0 +1,105 @@
+#pragma once
+
+#include <rosewood/rosewood.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace rosewood {
+
+    /**
+     * @brief PerfectHash places a set of distinct hashes into slots, at most one per slot, with the two level hash of
+     * rosewood::MemberTable. rwc builds the tables it generates with it, StaticIndex its own at run time.
+     */
+    struct PerfectHash {
+        static constexpr std::size_t npos = ~std::size_t(0);
+
+        std::vector<std::uint32_t> displacements;
+        // the index of the hash held by every slot, npos for the empty ones
+        std::vector<std::size_t> slots;
+
+        /**
+         * @return the one slot hash can be in
+         */
+        std::size_t slot_of(std::uint64_t hash) const noexcept {
+            return detail::perfect_hash_slot(hash, displacements[detail::perfect_hash_bucket(hash, displacements.size())], slots.size());
+        }
+
+        /**
+         * @return nothing if no table fits, which only happens to hashes that are the same
+         */
+        static std::optional<PerfectHash> build(const std::vector<std::uint64_t> &hashes);
+
+    private:
+        static std::optional<PerfectHash> build(const std::vector<std::uint64_t> &hashes, std::size_t slotCount);
+    };
+
+    inline std::optional<PerfectHash> PerfectHash::build(const std::vector<std::uint64_t> &hashes) {
+        // at least half of the slots are used to begin with, hashes that can't be told apart by any number of them give up the search
+        std::size_t slotCount = 1;
+        while (slotCount < hashes.size()) {
+            slotCount *= 2;
+        }
+        for (; slotCount <= 64 * std::max<std::size_t>(hashes.size(), 1); slotCount *= 2) {
+            if (auto table = build(hashes, slotCount)) {
+                return table;
+            }
+        }
+        return std::nullopt;
+    }
+
+    inline std::optional<PerfectHash> PerfectHash::build(const std::vector<std::uint64_t> &hashes, std::size_t slotCount) {
+        // per bucket, before trying with twice as many slots
+        constexpr std::uint32_t maxDisplacement = 1u << 16;
+
+        PerfectHash table;
+        table.displacements.assign(std::max<std::size_t>(1, (hashes.size() + 1) / 2), 0);
+        table.slots.assign(slotCount, npos);
+
+        std::vector<std::vector<std::size_t>> buckets(table.displacements.size());
+        for (std::size_t idx(0); idx < hashes.size(); ++idx) {
+            buckets[detail::perfect_hash_bucket(hashes[idx], buckets.size())].push_back(idx);
+        }
+        // the fuller a bucket, the harder it is to place, so those go first while most slots are free
+        std::vector<std::size_t> order(buckets.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&buckets] (std::size_t lhs, std::size_t rhs) {
+            return buckets[lhs].size() > buckets[rhs].size();
+        });
+
+        std::vector<std::size_t> placement;
+        for (const auto bucket: order) {
+            if (buckets[bucket].empty()) {
+                break;
+            }
+            bool placed = false;
+            for (std::uint32_t displacement(0); displacement < maxDisplacement && !placed; ++displacement) {
+                placement.clear();
+                placed = true;
+                for (const auto hash: buckets[bucket]) {
+                    const auto slot = detail::perfect_hash_slot(hashes[hash], displacement, slotCount);
+                    if (table.slots[slot] != npos || std::find(placement.begin(), placement.end(), slot) != placement.end()) {
+                        placed = false;
+                        break;
+                    }
+                    placement.push_back(slot);
+                }
+                if (placed) {
+                    table.displacements[bucket] = displacement;
+                    for (std::size_t idx(0); idx < placement.size(); ++idx) {
+                        table.slots[placement[idx]] = buckets[bucket][idx];
+                    }
+                }
+            }
+            if (!placed) {
+                return std::nullopt;
+            }
+        }
+        return table;
+    }
+
+}
@@ -1,62 +1,124 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <optional>
 #include <string_view>
 #include <algorithm>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace rosewood {
     struct nil_t {};
 
+    // None of these recurse over their elements, they expand packs instead: the instantiation depth doesn't grow with the number of
+    // members, and neither does the number of intermediate tuple types the compiler keeps around.
+
     template <template<typename> typename wrapping_type, typename ...Ts>
     struct tuple_elements_wrapper;
 
-    template <template<typename> typename wrapping_type, typename ...WrappedTupleTypes>
-    struct tuple_elements_wrapper<wrapping_type, std::tuple<WrappedTupleTypes...>, std::tuple<>> {
-        using type = std::tuple<WrappedTupleTypes...>;
-    };
-
-    template <template<typename> typename wrapping_type, typename ...WrappedTupleTypes, typename Head, typename ...UnwrappedTypes>
-    struct tuple_elements_wrapper<wrapping_type, std::tuple<WrappedTupleTypes...>, std::tuple<Head, UnwrappedTypes...>> {
-        using type = typename tuple_elements_wrapper<wrapping_type, std::tuple<WrappedTupleTypes..., wrapping_type<Head>>, std::tuple<UnwrappedTypes...>>::type;
+    template <template<typename> typename wrapping_type, typename ...WrappedTupleTypes, typename ...UnwrappedTypes>
+    struct tuple_elements_wrapper<wrapping_type, std::tuple<WrappedTupleTypes...>, std::tuple<UnwrappedTypes...>> {
+        using type = std::tuple<WrappedTupleTypes..., wrapping_type<UnwrappedTypes>...>;
     };
 
     template <template<typename> typename wrapping_type, typename ...Types>
     struct arguments_wrapper;
 
-    template <template<typename> typename wrapping_type, typename ...TupleTypes>
-    struct arguments_wrapper<wrapping_type, std::tuple<TupleTypes...>> {
-        using type = std::tuple<TupleTypes...>;
+    template <template<typename> typename wrapping_type, typename ...TupleTypes, typename ...Types>
+    struct arguments_wrapper<wrapping_type, std::tuple<TupleTypes...>, Types...> {
+        using type = std::tuple<TupleTypes..., wrapping_type<Types>...>;
     };
 
-    template <template<typename> typename wrapping_type, typename Head, typename ...Types, typename ...TupleTypes>
-    struct arguments_wrapper<wrapping_type, std::tuple<TupleTypes...>, Head, Types...> {
-        using type = typename arguments_wrapper<wrapping_type, std::tuple<TupleTypes..., wrapping_type<Head>>, Types...>::type;
+    namespace detail {
+    /**
+     * @brief tuple_concatenation knows where each element of the concatenation of Tuples comes from. A fold expression would do with less,
+     * but clang limits folds to as many operands as it does nested brackets
+     */
+    template <typename ...Tuples>
+    struct tuple_concatenation {
+        struct origin {
+            std::size_t tuple;
+            std::size_t element;
+        };
+
+        // the trailing 0 keeps the array valid without any tuple
+        static constexpr std::size_t tuple_sizes[] = {std::tuple_size<Tuples>::value..., 0};
+        static constexpr std::size_t size = [] {
+            std::size_t total = 0;
+            for (const std::size_t tupleSize: tuple_sizes) {
+                total += tupleSize;
+            }
+            return total;
+        }();
+        static constexpr std::array<origin, size> origins = [] {
+            std::array<origin, size> result{};
+            std::size_t idx = 0;
+            for (std::size_t tuple = 0; tuple < sizeof...(Tuples); ++tuple) {
+                for (std::size_t element = 0; element < tuple_sizes[tuple]; ++element) {
+                    result[idx++] = {tuple, element};
+                }
+            }
+            return result;
+        }();
     };
 
-    template <typename ...Tuples>
-    struct concatenate_tuples;
+    // pack_element_t is the element at Index of Types, picked by the compiler where it can or in a single overload resolution over the
+    // whole pack otherwise. std::tuple_element recurses through the elements before Index, with libstdc++ at least
+#if defined(__has_builtin)
+#if __has_builtin(__type_pack_element)
+#define ROSEWOOD_HAS_TYPE_PACK_ELEMENT
+#endif
+#endif
 
-    template <>
-    struct concatenate_tuples<> {
-        using type = std::tuple<>;
+#ifdef ROSEWOOD_HAS_TYPE_PACK_ELEMENT
+    template <std::size_t Index, typename ...Types>
+    using pack_element_t = __type_pack_element<Index, Types...>;
+#else
+    template <std::size_t Index, typename Type>
+    struct indexed_type {
+        using type = Type;
     };
 
-    template <typename ...Types>
-    struct concatenate_tuples<std::tuple<Types...>> {
-        using type = std::tuple<Types...>;
+    template <typename Indices, typename ...Types>
+    struct indexed_types;
+
+    template <std::size_t ...Indices, typename ...Types>
+    struct indexed_types<std::index_sequence<Indices...>, Types...> : indexed_type<Indices, Types>... {};
+
+    // only ever named in unevaluated operands, the base of the given index is the one that matches. Calls are qualified, looking
+    // into the namespaces of the types would instantiate them
+    template <std::size_t Index, typename Type>
+    indexed_type<Index, Type> select_indexed(const indexed_type<Index, Type>&);
+
+    template <std::size_t Index, typename ...Types>
+    using pack_element_t = typename decltype(rosewood::detail::select_indexed<Index>(std::declval<const indexed_types<std::index_sequence_for<Types...>, Types...>&>()))::type;
+#endif
+
+    template <std::size_t Index, typename Tuple>
+    struct tuple_pack_element;
+
+    template <std::size_t Index, typename ...Types>
+    struct tuple_pack_element<Index, std::tuple<Types...>> {
+        using type = pack_element_t<Index, Types...>;
     };
 
-    template <typename ...ConcatenatedTypes, typename ...NextTypes>
-    struct concatenate_tuples<std::tuple<ConcatenatedTypes...>, std::tuple<NextTypes...>> {
-        using type = std::tuple<ConcatenatedTypes..., NextTypes...>;
+    template <typename Concatenation, typename Indices>
+    struct concatenated_tuple;
+
+    template <typename ...Tuples, std::size_t ...Indices>
+    struct concatenated_tuple<tuple_concatenation<Tuples...>, std::index_sequence<Indices...>> {
+        using concatenation = tuple_concatenation<Tuples...>;
+        using type = std::tuple<typename tuple_pack_element<concatenation::origins[Indices].element, pack_element_t<concatenation::origins[Indices].tuple, Tuples...>>::type...>;
     };
+    }
 
-    template <typename ...ConcatenatedTypes, typename ...NextTypes, typename...moreTuples>
-    struct concatenate_tuples<std::tuple<ConcatenatedTypes...>, std::tuple<NextTypes...>, moreTuples...> {
-        using type = typename concatenate_tuples<std::tuple<ConcatenatedTypes..., NextTypes...>, moreTuples...>::type;
+    template <typename ...Tuples>
+    struct concatenate_tuples {
+        using type = typename detail::concatenated_tuple<detail::tuple_concatenation<Tuples...>, std::make_index_sequence<detail::tuple_concatenation<Tuples...>::size>>::type;
     };
 
 
@@ -116,14 +178,91 @@ namespace rosewood {
     template<typename Descriptor>
     struct Namespace {};
 
+    /**
+     * @brief no_enumerator marks the values of a dense enum value table that no enumerator has
+     */
+    inline constexpr std::uint32_t no_enumerator = ~std::uint32_t(0);
+
+    namespace detail {
+    // holds_value tells whether the integer or enum value is one of To. Enums are checked through their underlying types: casting
+    // a value an enum can't represent to it is undefined
+    template <typename To, typename From>
+    constexpr bool holds_value(From value) noexcept {
+        if constexpr (std::is_enum_v<From>) {
+            return holds_value<To>(static_cast<std::underlying_type_t<From>>(value));
+        } else if constexpr (std::is_enum_v<To>) {
+            return holds_value<std::underlying_type_t<To>>(value);
+        } else {
+            const auto converted = static_cast<To>(value);
+            if (static_cast<From>(converted) != value) {
+                return false;
+            }
+            // the round trip keeps the bits, what's left is a sign that flipped, which only a signed type can show
+            if constexpr (std::is_signed_v<From> && !std::is_signed_v<To>) {
+                return !(value < From{});
+            } else if constexpr (!std::is_signed_v<From> && std::is_signed_v<To>) {
+                return !(converted < To{});
+            } else {
+                return true;
+            }
+        }
+    }
+    }
+
+    /**
+     * Lookups go through tables generated along with the enumerators: by_name sorts their indices by name. by_value, with dense_values,
+     * holds the index of the enumerator of every value from lowest_value on, no_enumerator where there is none. Otherwise it sorts
+     * the indices of enumerators by value, aliases excluded. Either way, values map to the first enumerator declared with them.
+     */
     template<typename Descriptor>
     struct Enum {
         using descriptor = Descriptor;
 
-        constexpr bool in_range(int value) const {
-            return std::apply([value] (auto ...enums) {
-                return (... || (enums.value == value));
-            }, descriptor::enumerators);
+        template <typename ValueType>
+        constexpr bool in_range(ValueType value) const noexcept {
+            return index_of(value) != no_enumerator;
+        }
+
+        /**
+         * @return the name of the enumerator of value, empty if there is none
+         */
+        template <typename ValueType>
+        constexpr std::string_view to_string(ValueType value) const noexcept {
+            const auto index = index_of(value);
+            return index == no_enumerator ? std::string_view() : descriptor::enumerators[index].name;
+        }
+
+        /**
+         * @return the index of the enumerator called name in the enumerators of the descriptor, no_enumerator if there is none
+         */
+        constexpr std::uint32_t enumerator_index(std::string_view name) const noexcept {
+            std::size_t first = 0;
+            std::size_t count = descriptor::by_name.size();
+            while (count > 0) {
+                const std::size_t half = count / 2;
+                if (descriptor::enumerators[descriptor::by_name[first + half]].name < name) {
+                    first += half + 1;
+                    count -= half + 1;
+                } else {
+                    count = half;
+                }
+            }
+            if (first == descriptor::by_name.size() || descriptor::enumerators[descriptor::by_name[first]].name != name) {
+                return no_enumerator;
+            }
+            return descriptor::by_name[first];
+        }
+
+        /**
+         * @return the value of the enumerator called name, as the enum type
+         */
+        constexpr auto from_string(std::string_view name) const noexcept {
+            using enum_type = typename descriptor::type;
+            const auto index = enumerator_index(name);
+            if (index == no_enumerator) {
+                return std::optional<enum_type>();
+            }
+            return std::optional<enum_type>(static_cast<enum_type>(descriptor::enumerators[index].value));
         }
 
         template <typename visitorT>
@@ -132,12 +271,45 @@ namespace rosewood {
                 (visitor(enums), ...);
             }, descriptor::enumerators);
         }
+
+    private:
+        template <typename ValueType>
+        static constexpr std::uint32_t index_of(ValueType value) noexcept {
+            using value_type = typename descriptor::enumerator_type::value_type;
+            if (!detail::holds_value<value_type>(value)) {
+                return no_enumerator;
+            }
+            const auto key = static_cast<value_type>(value);
+            if constexpr (descriptor::dense_values) {
+                // wraps around below lowest_value, past the end of the table all the same
+                const std::uint64_t offset = static_cast<std::uint64_t>(key) - static_cast<std::uint64_t>(descriptor::lowest_value);
+                return offset < descriptor::by_value.size() ? descriptor::by_value[offset] : no_enumerator;
+            } else {
+                std::size_t first = 0;
+                std::size_t count = descriptor::by_value.size();
+                while (count > 0) {
+                    const std::size_t half = count / 2;
+                    if (descriptor::enumerators[descriptor::by_value[first + half]].value < key) {
+                        first += half + 1;
+                        count -= half + 1;
+                    } else {
+                        count = half;
+                    }
+                }
+                if (first == descriptor::by_value.size() || descriptor::enumerators[descriptor::by_value[first]].value != key) {
+                    return no_enumerator;
+                }
+                return descriptor::by_value[first];
+            }
+        }
     };
 
 
 
     template<typename EnumType>
     struct Enumerator {
+        using value_type = EnumType;
+
         constexpr std::string_view get_name() const noexcept {
             return name;
         }
@@ -369,15 +541,132 @@ namespace rosewood {
 
     };
 
+    /**
+     * @brief hash_name is the hash of names across rosewood, 64 bit FNV-1a. rwc builds the lookup tables it generates with it
+     */
+    constexpr std::uint64_t hash_name(std::string_view name) noexcept {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (const char c: name) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief hashed_name is a name along with its hash_name, computed once: at compile time for constants, see literals, or when it's
+     * made from a dynamic string. The lookups that take one skip hashing and compare hashes before names.
+     */
+    struct hashed_name {
+        constexpr hashed_name(std::string_view Name) noexcept
+            :name(Name),
+             hash(hash_name(Name)) {}
+
+        /**
+         * @param Hash hash_name(Name), such as the name_hash of a descriptor
+         */
+        constexpr hashed_name(std::string_view Name, std::uint64_t Hash) noexcept
+            :name(Name),
+             hash(Hash) {}
+
+        constexpr bool operator==(const hashed_name &other) const noexcept {
+            return hash == other.hash && name == other.name;
+        }
+
+        constexpr bool operator!=(const hashed_name &other) const noexcept {
+            return !(*this == other);
+        }
+
+        /**
+         * @brief hasher hands the hash over to unordered containers
+         */
+        struct hasher {
+            constexpr std::size_t operator()(const hashed_name &key) const noexcept {
+                return static_cast<std::size_t>(key.hash);
+            }
+        };
+
+        std::string_view name;
+        std::uint64_t hash;
+    };
+
+    namespace literals {
+        constexpr hashed_name operator""_name(const char *name, std::size_t length) noexcept {
+            return hashed_name(std::string_view(name, length));
+        }
+    }
+
+    namespace detail {
+    // the two levels of a perfect hash over a name hash: its upper half picks a bucket, whose displacement then scrambles the whole hash into a slot
+    constexpr std::size_t perfect_hash_bucket(std::uint64_t hash, std::size_t buckets) noexcept {
+        return static_cast<std::size_t>(hash >> 32) % buckets;
+    }
+
+    constexpr std::size_t perfect_hash_slot(std::uint64_t hash, std::uint32_t displacement, std::size_t slots) noexcept {
+        return static_cast<std::size_t>(((hash ^ displacement) * 0x9e3779b97f4a7c15ull) >> 32) % slots;
+    }
+    }
+
+    enum class MemberKind : std::uint8_t {
+        None,
+        Method,
+        Field,
+        Enum,
+        Class,
+        Namespace
+    };
+
+    /**
+     * @brief MemberSlot is a slot of a MemberTable. index is that of the member in the methods, fields, enums, classes or namespaces
+     * of its class or namespace, the first overload for methods. The other overloads follow it
+     */
+    struct MemberSlot {
+        std::string_view name;
+        MemberKind kind = MemberKind::None;
+        std::uint32_t index = 0;
+        // hash_name(name)
+        std::uint64_t hash = 0;
+    };
+
+    /**
+     * @brief MemberTable is a perfect hash table over the names of the members of a class, or of the declarations of a namespace
+     * or module, generated by rwc. Looking a name up hashes it once and compares it to the one name of the slot it lands in.
+     */
+    template <std::size_t Buckets, std::size_t Slots>
+    struct MemberTable {
+        static constexpr std::size_t npos = Slots;
+
+        std::array<std::uint32_t, Buckets> displacements;
+        std::array<MemberSlot, Slots> slots;
+
+        /**
+         * @return the slot of the member called name, npos if there is none
+         */
+        constexpr std::size_t slot_of(const hashed_name &name) const noexcept {
+            const std::size_t slot = detail::perfect_hash_slot(name.hash, displacements[detail::perfect_hash_bucket(name.hash, Buckets)], Slots);
+            return slots[slot].kind != MemberKind::None && slots[slot].hash == name.hash && slots[slot].name == name.name ? slot : npos;
+        }
+
+        constexpr const MemberSlot *find(const hashed_name &name) const noexcept {
+            const std::size_t slot = slot_of(name);
+            return slot != npos ? &slots[slot] : nullptr;
+        }
+    };
+
     template<typename Descriptor>
     struct StaticClass {
 
         using descriptor = Descriptor;
 
         constexpr bool has_method(std::string_view Name) const noexcept {
-            return std::apply([Name] (auto ...meth) {
-                return (... || (meth.name == Name));
-            }, Descriptor::methods);
+            const MemberSlot *member = Descriptor::member_table.find(Name);
+            return member && member->kind == MemberKind::Method;
+        }
+
+        /**
+         * @return the method, field, nested enum or nested class called Name, null if there is none
+         */
+        constexpr const MemberSlot *find_member(std::string_view Name) const noexcept {
+            return Descriptor::member_table.find(Name);
         }
 
         template<typename visitorT>
@@ -431,4 +720,12 @@ namespace rosewood {
     struct is_namespace<Namespace<DescType>> {
         static constexpr bool value = true;
     };
+
+    namespace detail {
+    // unlike is_class and is_enum, these hold for the generated descriptors, which derive from StaticClass and Enum
+    template <typename Descriptor>
+    inline constexpr bool is_class_descriptor = std::is_base_of_v<StaticClass<Descriptor>, Descriptor>;
+    template <typename Descriptor>
+    inline constexpr bool is_enum_descriptor = std::is_base_of_v<Enum<Descriptor>, Descriptor>;
+    }
 }
@@ -1,7 +1,13 @@
 #pragma once
 
 #include <rosewood/rosewood.hpp>
+#include <rosewood/names.hpp>
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
 #include <functional>
 #include <vector>
 #include <unordered_map>
@@ -14,8 +20,79 @@ namespace rosewood {
         using std::logic_error::logic_error;
     };
 
+    class signature_error : public std::logic_error {
+        using std::logic_error::logic_error;
+    };
+
     class DeclarationContext;
 
+    /**
+     * @brief type_id is the dense integer a type is given, from 0 on, the first time its id is asked for. Ids are stable for the
+     * lifetime of the process, not across processes, and only hold within one image: a shared library that hides its symbols or
+     * links its own copy of the runtime, as well as any Windows DLL, counts its types apart from the executable. Only compare the
+     * ids of models built and checked in the same image
+     */
+    enum class type_id : std::uint32_t {};
+
+    namespace detail {
+        type_id next_type_id() noexcept;
+
+        // what's left of a type once references, pointers and qualifiers are dropped, at any depth
+        template <typename T, typename Stripped = std::remove_cv_t<std::remove_pointer_t<std::remove_reference_t<T>>>>
+        struct atomic_type_of : atomic_type_of<Stripped> {};
+
+        template <typename T>
+        struct atomic_type_of<T, T> {
+            using type = T;
+        };
+
+        // the type of the objects the void pointers of DMethod::call point to
+        template <typename T>
+        using slot_type = std::remove_cv_t<std::remove_reference_t<T>>;
+
+        template <typename ReturnType, typename ...ArgTypes>
+        struct signature {};
+
+        /**
+         * @brief type_name is the name of T as the compiler spells it, taken from the signature of this very function
+         */
+        template <typename T>
+        constexpr std::string_view type_name() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+            constexpr std::string_view function = __FUNCSIG__;
+            constexpr std::string_view prefix = "type_name<";
+            constexpr std::size_t begin = function.find(prefix) + prefix.size();
+            constexpr std::size_t end = function.rfind(">(void)");
+#else
+            // [T = int] for clang, [with T = int; std::string_view = ...] for gcc
+            constexpr std::string_view function = __PRETTY_FUNCTION__;
+            constexpr std::string_view prefix = "T = ";
+            constexpr std::size_t begin = function.find(prefix) + prefix.size();
+            constexpr std::size_t end = function.find(';', begin) != std::string_view::npos ? function.find(';', begin) : function.size() - 1;
+#endif
+            return function.substr(begin, end - begin);
+        }
+    }
+
+    /**
+     * @brief type_id_of is the id of T, cv and reference qualifiers included
+     */
+    template <typename T>
+    type_id type_id_of() noexcept {
+        static const type_id id = detail::next_type_id();
+        return id;
+    }
+
+    /**
+     * @brief signature_of identifies a method by the types of the objects DMethod::call expects its arguments and return value in:
+     * references and top level qualifiers don't matter, as `int` is what a `const int&` parameter reads. Resolve it once and hand
+     * it over to DMethod::checked_call
+     */
+    template <typename ReturnType, typename ...ArgTypes>
+    type_id signature_of() noexcept {
+        return type_id_of<detail::signature<detail::slot_type<ReturnType>, detail::slot_type<ArgTypes>...>>();
+    }
+
     class DType {
     public:
         virtual ~DType() = 0;
@@ -34,6 +111,10 @@ namespace rosewood {
          * @return
          */
         virtual std::string_view getAtomicName() const noexcept = 0;
+        /**
+         * @brief getTypeId tells types apart with a single comparison, see type_id_of
+         */
+        virtual type_id getTypeId() const noexcept = 0;
     };
 
     template <typename UnderlyingType>
@@ -56,10 +137,46 @@ namespace rosewood {
             return typeInstance.atomic_name;
         }
 
+        inline virtual type_id getTypeId() const noexcept final {
+            return type_id_of<typename UnderlyingType::type>();
+        }
+
     private:
         const UnderlyingType typeInstance;
     };
 
+    /**
+     * @brief DNativeType describes T without a descriptor, spelled the way the compiler does: its name and canonical name are the same
+     */
+    template <typename T>
+    class DNativeType final : public DType {
+    public:
+        inline virtual std::string_view getCanonicalName() const noexcept final {
+            return detail::type_name<T>();
+        }
+
+        inline virtual std::string_view getName() const noexcept final {
+            return detail::type_name<T>();
+        }
+
+        inline virtual std::string_view getAtomicName() const noexcept final {
+            return detail::type_name<typename detail::atomic_type_of<T>::type>();
+        }
+
+        inline virtual type_id getTypeId() const noexcept final {
+            return type_id_of<T>();
+        }
+    };
+
+    /**
+     * @return the one DNativeType of T
+     */
+    template <typename T>
+    const DType *type_of() noexcept {
+        static const DNativeType<T> type;
+        return &type;
+    }
+
     class DTypedDeclaration {
     public:
         virtual ~DTypedDeclaration() = 0;
@@ -94,8 +211,20 @@ namespace rosewood {
 
         virtual const DeclarationContext *parent() const noexcept;
 
+        /**
+         * @brief getNameId is the id of the name of this declaration in NameTable::global(). The name is interned the first time its
+         * id is asked for, later calls read it back without locking
+         */
+        name_id getNameId() const;
+        /**
+         * @brief isCalled tells whether this declaration is called name, comparing ids rather than strings. It never grows the table
+         */
+        bool isCalled(name_id name) const noexcept;
+
     private:
         const DeclarationContext *parentP;
+        // no_name until the id is first resolved, names are never interned while the model is built
+        mutable std::atomic<name_id> nameId{no_name};
     };
 
     class TypeDeclaration : public Declaration {
@@ -112,8 +241,39 @@ namespace rosewood {
     public:
         virtual ~DeclarationContext() = 0;
         virtual const Declaration *getDeclaration(std::string_view name) const noexcept = 0;
+        /**
+         * @brief getDeclaration looks name up without hashing it again. Contexts that don't override it look the string up
+         */
+        virtual const Declaration *getDeclaration(const hashed_name &name) const noexcept;
+        /**
+         * @brief getDeclaration looks up the name an id was given, see NameTable. Contexts that don't override it look the name of the id up
+         */
+        virtual const Declaration *getDeclaration(name_id name) const noexcept;
     };
 
+    namespace detail {
+        /**
+         * @brief declaration_ids finds the declarations of a context by the ids of their names, with a binary search over integers.
+         * The sorted ids are only resolved by the first find, concurrent first finds may each sort them and the first to publish wins
+         */
+        class declaration_ids {
+        public:
+            declaration_ids() = default;
+            declaration_ids(const declaration_ids&) = delete;
+            declaration_ids &operator=(const declaration_ids&) = delete;
+            ~declaration_ids();
+
+            void add(const Declaration *declaration);
+            const Declaration *find(name_id name) const noexcept;
+
+        private:
+            using entries_type = std::vector<std::pair<name_id, const Declaration*>>;
+
+            std::vector<const Declaration*> declarations;
+            mutable std::atomic<const entries_type*> entries{nullptr};
+        };
+    }
+
     class Class;
 
     template <typename Descriptor>
@@ -126,12 +286,14 @@ namespace rosewood {
 
         virtual ~DEnumerator() = 0;
         virtual long long getValue() const noexcept = 0;
+        const DEnumerator *asEnumerator() const noexcept final;
     };
 
     template <typename Descriptor>
     class DEnumeratorWrapper : public DEnumerator {
     public:
-        DEnumeratorWrapper(const Descriptor &d, const DeclarationContext *parent) : DEnumerator(parent), descriptor(d) {}
+        DEnumeratorWrapper(const Descriptor &d, const DeclarationContext *parent) : DEnumerator(parent), descriptor(d) {
+        }
 
         inline virtual std::string_view getName() const noexcept final {
             return descriptor.name;
@@ -164,6 +326,7 @@ namespace rosewood {
                 enumerators.emplace_back(
                     std::make_unique<DEnumeratorWrapper<typename descriptor::enumerator_type>>(en, this)
                 );
+                ids.add(enumerators.back().get());
             }
         }
 
@@ -173,18 +336,21 @@ namespace rosewood {
             return descriptor::name;
         }
 
+        using DEnum::getDeclaration;
+
+        // enumerators are found with the sorted names of the descriptor rather than by hash
         const Declaration *getDeclaration(std::string_view name) const noexcept final {
-            auto res = std::find_if(enumerators.begin(), enumerators.end(), [name, this](const std::unique_ptr<DEnumerator> &enumerator){
-                return enumerator->getName() == name;
-            });
-            if (res != enumerators.end()) {
-                return res->get();
-            }
-            return nullptr;
+            const auto index = MetaEnum{}.enumerator_index(name);
+            return index != no_enumerator ? enumerators[index].get() : nullptr;
+        }
+
+        const Declaration *getDeclaration(name_id name) const noexcept final {
+            return ids.find(name);
         }
 
     private:
         std::vector<std::unique_ptr<DEnumerator>> enumerators;
+        detail::declaration_ids ids;
     };
 
     template <typename T>
@@ -207,35 +373,49 @@ namespace rosewood {
     private:
     };
 
+    /**
+     * @brief DParameter is a parameter of a method. Methods aren't declaration contexts, so its parent is that of its method
+     */
     class DParameter : public Declaration, public DTypedDeclaration {
     public:
+        using Declaration::Declaration;
+
         virtual ~DParameter() = 0;
+        virtual bool hasDefaultValue() const noexcept = 0;
     };
 
     template <typename Descriptor>
     class DParameterWrapper : public DParameter {
     public:
+        DParameterWrapper(const Descriptor &desc, const DeclarationContext *parent)
+            : DParameter(parent),
+              descriptor(desc) {
+        }
+
         inline virtual ~DParameterWrapper() = default;
         inline virtual std::string_view getName() const noexcept final {
-            return Descriptor::name;
+            return descriptor.name;
         }
 
         inline virtual const DType *getType() const noexcept final {
-            return &type;
+            return type_of<typename Descriptor::type_t>();
+        }
+
+        inline virtual bool hasDefaultValue() const noexcept final {
+            return descriptor.isDefaulted;
         }
 
     private:
-        using param_type = DTypeWrapper<decltype(Descriptor::type)>;
-        static const param_type type;
+        Descriptor descriptor;
     };
 
-    template<typename Descriptor>
-    const typename DParameterWrapper<Descriptor>::param_type DParameterWrapper<Descriptor>::type(Descriptor::type);
-
 
     class DMethod : public Declaration {
     public:
-        using Declaration::Declaration;
+        /**
+         * @param Signature the signature_of the method
+         */
+        DMethod(const DeclarationContext *parent, type_id Signature);
         virtual ~DMethod() = 0;
 
         /**
@@ -248,23 +428,81 @@ namespace rosewood {
         virtual void call(const void *object, void *retValAddr, void **args) const = 0;
         virtual void call(void *object, void *retValAddr, void **args) const = 0;
 
+        /**
+         * @brief checked_call is call, once signature, the signature_of the types the caller passes, was found to be that of this
+         * method: a single integer comparison
+         * @throws signature_error if it isn't
+         */
+        void checked_call(const void *object, void *retValAddr, void **args, type_id signature) const;
+        void checked_call(void *object, void *retValAddr, void **args, type_id signature) const;
+
         virtual const DType *getReturnType() const noexcept = 0;
+        virtual std::size_t getParameterCount() const noexcept = 0;
+        /**
+         * @return the parameter at index, null past the last one
+         */
+        virtual const DParameter *getParameter(std::size_t index) const noexcept = 0;
+
+        type_id getSignature() const noexcept { return signatureId; }
+        bool hasSignature(type_id signature) const noexcept { return signatureId == signature; }
+
         const DMethod *getNextOverload() const noexcept;
+        /**
+         * @return the overload, this one included, that has signature, null if there is none
+         */
+        const DMethod *findOverload(type_id signature) const noexcept;
 
         void pushOverload(std::unique_ptr<DMethod> &&next);
         const DMethod *asMethod() const noexcept final;
     private:
+        const type_id signatureId;
         std::unique_ptr<DMethod> nextOverload = nullptr;
     };
 
+    namespace detail {
+        template <std::size_t Index, typename Descriptor>
+        struct parameter_holder {
+            DParameterWrapper<Descriptor> parameter;
+        };
+
+        /**
+         * @brief parameter_list holds the parameters of a method in place, one base per parameter, and an array pointing to them
+         */
+        template <typename ArgTypes, typename Indices = std::make_index_sequence<std::tuple_size_v<ArgTypes>>>
+        struct parameter_list;
+
+        template <typename ...Descriptors, std::size_t ...Indices>
+        struct parameter_list<std::tuple<Descriptors...>, std::index_sequence<Indices...>> : parameter_holder<Indices, Descriptors>... {
+            parameter_list(const std::tuple<Descriptors...> &args, const DeclarationContext *parent)
+                : parameter_holder<Indices, Descriptors>{DParameterWrapper<Descriptors>(std::get<Indices>(args), parent)}...,
+                  parameters{{&this->parameter_holder<Indices, Descriptors>::parameter...}} {}
+
+            // the array points into this very object
+            parameter_list(const parameter_list&) = delete;
+            parameter_list &operator=(const parameter_list&) = delete;
+
+            const std::array<const DParameter*, sizeof...(Descriptors)> parameters;
+        };
+
+        template <typename Descriptor, typename ArgTypes = typename Descriptor::arg_types>
+        struct method_signature;
+
+        template <typename Descriptor, typename ...Parameters>
+        struct method_signature<Descriptor, std::tuple<Parameters...>> {
+            static type_id get() noexcept {
+                return signature_of<typename Descriptor::return_type, typename Parameters::type_t...>();
+            }
+        };
+    }
+
     template <typename Descriptor>
     class DMethodWrapper : public DMethod {
     public:
 
         DMethodWrapper(const Descriptor& desc, const DeclarationContext* parent)
-            : DMethod(parent),
-              descriptor(desc) {
-        }
+            : DMethod(parent, detail::method_signature<Descriptor>::get()),
+              descriptor(desc),
+              parameters(descriptor.args, parent) {}
 
         inline virtual std::string_view getName() const noexcept final {
             return descriptor.name;
@@ -283,17 +521,20 @@ namespace rosewood {
         }
 
         inline virtual const DType *getReturnType() const noexcept final {
-            return nullptr; //  &returntype;
+            return type_of<typename Descriptor::return_type>();
         }
 
-    private:
-        // using parameter_model = detail::range_model<typename Descriptor::parameters, DParameter, DParameterWrapper>;
-        // static constexpr parameter_model parameters {};
+        inline virtual std::size_t getParameterCount() const noexcept final {
+            return Descriptor::num_args;
+        }
 
-        // using return_type = DTypeWrapper<Descriptor::return_type>;
-        // static const return_type returntype;
+        inline virtual const DParameter *getParameter(std::size_t index) const noexcept final {
+            return index < parameters.parameters.size() ? parameters.parameters[index] : nullptr;
+        }
 
+    private:
         Descriptor descriptor;
+        detail::parameter_list<typename Descriptor::arg_types> parameters;
     };
 
     template <typename T>
@@ -310,9 +551,6 @@ namespace rosewood {
     }
 
 
-    // template <typename Descriptor>
-    // const typename DMethodWrapper<Descriptor>::return_type DMethodWrapper<Descriptor>::returntype(Descriptor::return_type);
-
     class DField : public Declaration, public DTypedDeclaration {
     public:
         using Declaration::Declaration;
@@ -331,14 +569,15 @@ namespace rosewood {
 
         DFieldWrapper(const Descriptor &desc, const DeclarationContext *parent)
             :DField(parent),
-             descriptor(desc) {}
+             descriptor(desc) {
+        }
 
         inline virtual std::string_view getName() const noexcept final {
             return descriptor.name;
         }
 
         inline virtual const DType *getType() const noexcept final {
-            return nullptr; // &type;
+            return type_of<typename Descriptor::type_t>();
         }
 
         inline virtual void assign_copy(void* o, void* a) const final {
@@ -350,8 +589,6 @@ namespace rosewood {
         }
 
     private:
-        // using type_information = DTypeWrapper<decltype(Descriptor::type)>;
-        // static const type_information type;
         Descriptor descriptor;
     };
 
@@ -360,9 +597,6 @@ namespace rosewood {
         return std::make_unique<DFieldWrapper<T>>(d, p);
     }
 
-    // template <typename Descriptor>
-    // const typename DFieldWrapper<Descriptor>::type_information DFieldWrapper<Descriptor>::type(Descriptor::type);
-
     class Class : public TypeDeclaration, public DeclarationContext {
     public:
         using TypeDeclaration::TypeDeclaration;
@@ -381,10 +615,15 @@ namespace rosewood {
 
         ClassWrapper(const MetaClass &mc, const DeclarationContext *parent)
             : Class(parent) {
-
             initMethods();
             initEnums();
             initFields();
+            initClasses();
+            for (const auto &declaration: declarations) {
+                if (declaration) {
+                    ids.add(declaration.get());
+                }
+            }
         }
 
         inline ~ClassWrapper() = default;
@@ -394,27 +633,50 @@ namespace rosewood {
         }
 
         inline const Declaration *getDeclaration(std::string_view name) const noexcept final {
-            if (auto res = declarations.find(name); res != declarations.end()) {
-                return res->second.get();
-            }
-            return nullptr;
+            return getDeclaration(hashed_name(name));
+        }
+
+        inline const Declaration *getDeclaration(const hashed_name &name) const noexcept final {
+            const auto slot = descriptor::member_table.slot_of(name);
+            return slot != descriptor::member_table.npos ? declarations[slot].get() : nullptr;
+        }
+
+        inline const Declaration *getDeclaration(name_id name) const noexcept final {
+            return ids.find(name);
         }
 
     private:
+        // the slot of a member, unless another one of the same name took it
+        static constexpr bool owns_slot(std::size_t slot, MemberKind kind) noexcept {
+            return slot != descriptor::member_table.npos && descriptor::member_table.slots[slot].kind == kind;
+        }
+
         void initMethods() {
-            std::unordered_map<std::string_view, std::unique_ptr<DMethod>> all_methods;
-            std::apply([&all_methods, this](auto &&...mts) {
-                bool added;
-                (((added = static_cast<bool>(all_methods[mts.name])), (added ? all_methods[mts.name]->pushOverload(makeUniqueMethod(mts, this)) : static_cast<void>(all_methods[mts.name] = makeUniqueMethod(mts, this)))), ...);
+            std::apply([this](auto &&...mts) {
+                ([this](const auto &method) {
+                    const auto slot = descriptor::member_table.slot_of(method.name);
+                    if (!owns_slot(slot, MemberKind::Method)) {
+                        return;
+                    }
+                    if (declarations[slot]) {
+                        static_cast<DMethod*>(declarations[slot].get())->pushOverload(makeUniqueMethod(method, this));
+                    } else {
+                        declarations[slot] = makeUniqueMethod(method, this);
+                    }
+                }(mts), ...);
             }, descriptor::methods);
-            for (auto& [nm, pv]: all_methods) {
-                declarations[nm] = std::move(pv);
+        }
+
+        template <typename MemberDescriptor, typename MakeT>
+        void initMember(const MemberDescriptor &member, MemberKind kind, MakeT make) {
+            if (const auto slot = descriptor::member_table.slot_of(member.name); owns_slot(slot, kind)) {
+                declarations[slot] = make(member, this);
             }
         }
 
         void initFields() {
             std::apply([this](auto &&...fields) {
-                ((declarations[fields.name] = makeField(fields, this)), ...);
+                (initMember(fields, MemberKind::Field, [](const auto &field, const DeclarationContext *p) { return makeField(field, p); }), ...);
             }, descriptor::fields);
         }
 
@@ -422,11 +684,21 @@ namespace rosewood {
             using enums_type = typename descriptor::enums;
             enums_type enums;
             std::apply([this](auto &&...enms) {
-                ((declarations[enms.name] = makeEnum(enms, this)), ...);
+                (initMember(enms, MemberKind::Enum, [](const auto &en, const DeclarationContext *p) { return makeEnum(en, p); }), ...);
             }, enums);
         }
 
-        std::unordered_map<std::string_view, std::unique_ptr<Declaration>> declarations;
+        void initClasses() {
+            using classes_type = typename descriptor::classes;
+            classes_type classes;
+            std::apply([this](auto &&...clses) {
+                (initMember(clses, MemberKind::Class, [](const auto &cls, const DeclarationContext *p) { return makeClass(cls, p); }), ...);
+            }, classes);
+        }
+
+        // one per slot of the member table of the descriptor, which resolves names to them
+        std::array<std::unique_ptr<Declaration>, descriptor::member_table.slots.size()> declarations;
+        detail::declaration_ids ids;
     };
 
     template <typename T>
@@ -462,6 +734,9 @@ namespace rosewood {
             initClasses();
             initNamespaces();
             initEnums();
+            for (const auto &declaration: declarations) {
+                ids.add(declaration.second.get());
+            }
         }
 
         inline virtual ~DNamespaceWrapper() = default;
@@ -471,17 +746,25 @@ namespace rosewood {
         }
 
         inline const Declaration *getDeclaration(std::string_view name) const noexcept final {
+            return getDeclaration(hashed_name(name));
+        }
+
+        inline const Declaration *getDeclaration(const hashed_name &name) const noexcept final {
             auto res = declarations.find(name);
             return res != declarations.end() ? res->second.get() : nullptr;
         }
 
+        inline const Declaration *getDeclaration(name_id name) const noexcept final {
+            return ids.find(name);
+        }
+
     protected:
 
         void initEnums() {
             using enums_type = typename MetaNamespace::enums;
             enums_type enums;
             std::apply([this](auto &&...enms) {
-                ((declarations[enms.name] = makeEnum(enms, this)), ...);
+                ((declarations[hashed_name(enms.name, enms.name_hash)] = makeEnum(enms, this)), ...);
             }, enums);
         }
 
@@ -489,7 +772,7 @@ namespace rosewood {
             using classes_tuple = typename MetaNamespace::classes;
             classes_tuple ctup;
             std::apply([this](auto &&...clses) {
-                ((declarations[clses.name] = makeClass(clses, this)), ...);
+                ((declarations[hashed_name(clses.name, clses.name_hash)] = makeClass(clses, this)), ...);
             }, ctup);
         }
 
@@ -498,10 +781,12 @@ namespace rosewood {
             namespaces_tuple namespaces;
 
             std::apply([this](auto &&...nmspcs) {
-                ((declarations[nmspcs.name] = makeNamespace(nmspcs, this)), ...);
+                ((declarations[hashed_name(nmspcs.name, nmspcs.name_hash)] = makeNamespace(nmspcs, this)), ...);
             }, namespaces);
         }
-        std::unordered_map<std::string_view, std::unique_ptr<Declaration>> declarations;
+        // keyed by the hashes generated along with the descriptors
+        std::unordered_map<hashed_name, std::unique_ptr<Declaration>, hashed_name::hasher> declarations;
+        detail::declaration_ids ids;
     };
 
     template <typename T>
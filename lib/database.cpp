@@ -0,0 +1,102 @@
+#include <rosewood/database.hpp>
+
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rosewood {
+
+    namespace {
+        template <typename Record>
+        bool fits(const db::Section &section, std::size_t size) noexcept {
+            return section.offset % alignof(std::uint64_t) == 0 && section.offset <= size && (size - section.offset) / sizeof(Record) >= section.count;
+        }
+    }
+
+    Database::Database(const std::string &path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw database_error(path + ": " + std::strerror(errno));
+        }
+        struct stat status;
+        if (::fstat(fd, &status) != 0 || status.st_size == 0) {
+            ::close(fd);
+            throw database_error(path + ": not a reflection database");
+        }
+        void *address = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps the file alive on its own
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            throw database_error(path + ": " + std::strerror(errno));
+        }
+        data = static_cast<const unsigned char*>(address);
+        dataSize = static_cast<std::size_t>(status.st_size);
+        mapped = true;
+        try {
+            validate();
+        } catch (const database_error &error) {
+            unmap();
+            throw database_error(path + ": " + error.what());
+        }
+    }
+
+    Database::Database(const void *Data, std::size_t size)
+        :data(static_cast<const unsigned char*>(Data)),
+         dataSize(size) {
+        validate();
+    }
+
+    Database::Database(Database &&other) noexcept
+        :data(std::exchange(other.data, nullptr)),
+         dataSize(std::exchange(other.dataSize, 0)),
+         mapped(std::exchange(other.mapped, false)) {}
+
+    Database &Database::operator=(Database &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            data = std::exchange(other.data, nullptr);
+            dataSize = std::exchange(other.dataSize, 0);
+            mapped = std::exchange(other.mapped, false);
+        }
+        return *this;
+    }
+
+    Database::~Database() {
+        unmap();
+    }
+
+    void Database::unmap() noexcept {
+        if (mapped) {
+            ::munmap(const_cast<unsigned char*>(data), dataSize);
+        }
+        data = nullptr;
+        dataSize = 0;
+        mapped = false;
+    }
+
+    void Database::validate() {
+        // only the header and the bounds of the sections are checked, which doesn't depend on the size of the database
+        if (reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint64_t) != 0) {
+            throw database_error("misaligned reflection database");
+        }
+        if (dataSize < sizeof(db::FileHeader) || std::memcmp(header().magic, db::magic, sizeof(db::magic)) != 0) {
+            throw database_error("not a reflection database");
+        }
+        if (header().byteOrder != db::byteOrder) {
+            throw database_error("reflection database written on a machine of another byte order");
+        }
+        if (header().version != db::version) {
+            throw database_error("reflection database version " + std::to_string(header().version) + " isn't supported, expected version " + std::to_string(db::version));
+        }
+        const auto &file = header();
+        if (!fits<db::DeclarationRecord>(file.declarations, dataSize) || file.declarations.count == 0 || !fits<db::MemberRecord>(file.members, dataSize)
+                || !fits<db::ParameterRecord>(file.parameters, dataSize) || !fits<db::TypeRecord>(file.types, dataSize) || !fits<char>(file.strings, dataSize)) {
+            throw database_error("truncated reflection database");
+        }
+    }
+
+}
@@ -1,5 +1,74 @@
 #include <rosewood/index.hpp>
+#include <rosewood/perfect_hash.hpp>
 
 namespace rosewood {
 
+    void QualifiedNameTable::add(std::string_view qualifiedName, const Declaration *declaration) {
+        // duplicates are only told apart by build
+        entries.push_back(Entry{hash_name(qualifiedName), static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(qualifiedName.size()), declaration});
+        names.append(qualifiedName);
+    }
+
+    bool QualifiedNameTable::matches(std::uint32_t entry, std::uint64_t hash, std::string_view qualifiedName) const noexcept {
+        return entries[entry].hash == hash && nameOf(entries[entry]) == qualifiedName;
+    }
+
+    void QualifiedNameTable::build(Hashing hashing) {
+        // linear probing first, which also drops the names added more than once
+        std::size_t capacity = 2;
+        while (capacity < 2 * entries.size()) {
+            capacity *= 2;
+        }
+        slots.assign(capacity, emptySlot);
+        displacements.clear();
+        std::size_t distinct = 0;
+        for (std::size_t idx(0); idx < entries.size(); ++idx) {
+            const Entry &entry = entries[idx];
+            std::size_t slot = static_cast<std::size_t>(entry.hash) & (capacity - 1);
+            while (slots[slot] != emptySlot && !matches(slots[slot], entry.hash, nameOf(entry))) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            if (slots[slot] == emptySlot) {
+                entries[distinct] = entry;
+                slots[slot] = static_cast<std::uint32_t>(distinct++);
+            }
+        }
+        entries.resize(distinct);
+
+        if (hashing != Hashing::Perfect) {
+            return;
+        }
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(entries.size());
+        for (const auto &entry: entries) {
+            hashes.push_back(entry.hash);
+        }
+        if (const auto perfect = PerfectHash::build(hashes)) {
+            displacements = perfect->displacements;
+            slots.assign(perfect->slots.size(), emptySlot);
+            for (std::size_t slot(0); slot < perfect->slots.size(); ++slot) {
+                if (perfect->slots[slot] != PerfectHash::npos) {
+                    slots[slot] = static_cast<std::uint32_t>(perfect->slots[slot]);
+                }
+            }
+        }
+    }
+
+    const Declaration *QualifiedNameTable::find(const hashed_name &qualifiedName) const noexcept {
+        if (slots.empty()) {
+            return nullptr;
+        }
+        const std::uint64_t hash = qualifiedName.hash;
+        if (isPerfect()) {
+            const std::uint32_t entry = slots[detail::perfect_hash_slot(hash, displacements[detail::perfect_hash_bucket(hash, displacements.size())], slots.size())];
+            return entry != emptySlot && matches(entry, hash, qualifiedName.name) ? entries[entry].declaration : nullptr;
+        }
+        for (std::size_t slot = static_cast<std::size_t>(hash) & (slots.size() - 1); slots[slot] != emptySlot; slot = (slot + 1) & (slots.size() - 1)) {
+            if (matches(slots[slot], hash, qualifiedName.name)) {
+                return entries[slots[slot]].declaration;
+            }
+        }
+        return nullptr;
+    }
+
 }
@@ -0,0 +1,47 @@
+#include <rosewood/names.hpp>
+
+#include <mutex>
+
+namespace rosewood {
+
+    NameTable &NameTable::global() {
+        static NameTable table;
+        return table;
+    }
+
+    name_id NameTable::intern(const hashed_name &name) {
+        if (const name_id existing = find(name); existing != no_name) {
+            return existing;
+        }
+        std::unique_lock lock(mutex);
+        // another thread may have interned it in between
+        if (const auto found = ids.find(name); found != ids.end()) {
+            return found->second;
+        }
+        const Entry &stored = names.emplace_back(Entry{std::string(name.name), name.hash});
+        const name_id id = name_id(static_cast<std::uint32_t>(names.size() - 1));
+        ids.emplace(hashed_name(stored.name, stored.hash), id);
+        return id;
+    }
+
+    name_id NameTable::find(const hashed_name &name) const noexcept {
+        std::shared_lock lock(mutex);
+        const auto found = ids.find(name);
+        return found != ids.end() ? found->second : no_name;
+    }
+
+    hashed_name NameTable::name(name_id id) const noexcept {
+        std::shared_lock lock(mutex);
+        const auto idx = static_cast<std::size_t>(id);
+        if (idx >= names.size()) {
+            return hashed_name(std::string_view());
+        }
+        return hashed_name(names[idx].name, names[idx].hash);
+    }
+
+    std::size_t NameTable::size() const noexcept {
+        std::shared_lock lock(mutex);
+        return names.size();
+    }
+
+}
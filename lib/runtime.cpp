@@ -1,5 +1,8 @@
 #include <rosewood/runtime.hpp>
 
+#include <algorithm>
+#include <atomic>
+
 
 namespace rosewood {
     DType::~DType() = default;
@@ -8,6 +11,51 @@ namespace rosewood {
     DeclarationContext::~DeclarationContext() = default;
     TypeDeclaration::~TypeDeclaration() = default;
 
+    const Declaration *DeclarationContext::getDeclaration(const hashed_name &name) const noexcept {
+        return getDeclaration(name.name);
+    }
+
+    const Declaration *DeclarationContext::getDeclaration(name_id name) const noexcept {
+        if (name == no_name) {
+            return nullptr;
+        }
+        const hashed_name resolved = NameTable::global().name(name);
+        return resolved.name.empty() ? nullptr : getDeclaration(resolved);
+    }
+
+    detail::declaration_ids::~declaration_ids() {
+        delete entries.load(std::memory_order_acquire);
+    }
+
+    void detail::declaration_ids::add(const Declaration *declaration) {
+        declarations.push_back(declaration);
+    }
+
+    const Declaration *detail::declaration_ids::find(name_id name) const noexcept {
+        if (name == no_name) {
+            return nullptr;
+        }
+        const entries_type *sorted = entries.load(std::memory_order_acquire);
+        if (!sorted) {
+            auto created = std::make_unique<entries_type>();
+            created->reserve(declarations.size());
+            for (const Declaration *declaration: declarations) {
+                created->emplace_back(declaration->getNameId(), declaration);
+            }
+            std::sort(created->begin(), created->end(), [] (const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+            const entries_type *expected = nullptr;
+            if (entries.compare_exchange_strong(expected, created.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                sorted = created.release();
+            } else {
+                sorted = expected;
+            }
+        }
+        const auto found = std::lower_bound(sorted->begin(), sorted->end(), name, [] (const auto &entry, name_id value) {
+            return entry.first < value;
+        });
+        return found != sorted->end() && found->first == name ? found->second : nullptr;
+    }
+
     Declaration::Declaration(const DeclarationContext *Parent)
         :parentP(Parent) {}
 
@@ -15,6 +63,31 @@ namespace rosewood {
         return parentP;
     }
 
+    name_id Declaration::getNameId() const {
+        if (const name_id cached = nameId.load(std::memory_order_acquire); cached != no_name) {
+            return cached;
+        }
+        // ids never change once given, threads racing here store the same one
+        const name_id interned = NameTable::global().intern(getName());
+        nameId.store(interned, std::memory_order_release);
+        return interned;
+    }
+
+    bool Declaration::isCalled(name_id name) const noexcept {
+        if (name == no_name) {
+            return false;
+        }
+        if (const name_id cached = nameId.load(std::memory_order_acquire); cached != no_name) {
+            return cached == name;
+        }
+        // name was interned, so this declaration is called name only if its own name was too
+        const name_id found = NameTable::global().find(getName());
+        if (found != no_name) {
+            nameId.store(found, std::memory_order_release);
+        }
+        return found == name;
+    }
+
     const DNamespace *Declaration::asNamespace() const noexcept {
         return nullptr;
     }
@@ -51,6 +124,37 @@ namespace rosewood {
         return this;
     }
 
+    type_id detail::next_type_id() noexcept {
+        static std::atomic<std::uint32_t> next{0};
+        return type_id(next.fetch_add(1, std::memory_order_relaxed));
+    }
+
+    DMethod::DMethod(const DeclarationContext *parent, type_id Signature)
+        :Declaration(parent),
+         signatureId(Signature) {}
+
+    void DMethod::checked_call(const void *object, void *retValAddr, void **args, type_id signature) const {
+        if (signature != signatureId) {
+            throw signature_error("argument or return types don't match those of the method");
+        }
+        call(object, retValAddr, args);
+    }
+
+    void DMethod::checked_call(void *object, void *retValAddr, void **args, type_id signature) const {
+        if (signature != signatureId) {
+            throw signature_error("argument or return types don't match those of the method");
+        }
+        call(object, retValAddr, args);
+    }
+
+    const DMethod *DMethod::findOverload(type_id signature) const noexcept {
+        const DMethod *overload = this;
+        while (overload && overload->signatureId != signature) {
+            overload = overload->nextOverload.get();
+        }
+        return overload;
+    }
+
     const DMethod *DMethod::getNextOverload() const noexcept {
         return nextOverload.get();
     }
@@ -95,4 +199,8 @@ namespace rosewood {
     const DMethod *DMethod::asMethod() const noexcept {
         return this;
     }
+
+    const DEnumerator *DEnumerator::asEnumerator() const noexcept {
+        return this;
+    }
 }
@@ -19,35 +19,242 @@
 #include <clang/Basic/SourceManager.h>
 #include <clang/Frontend/ASTConsumers.h>
 #include <clang/Lex/HeaderSearch.h>
+#include <clang/Lex/Preprocessor.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/TimeProfiler.h>
 #pragma warning(pop)
 
+#include <algorithm>
+
 namespace mc {
 
+    void applyFrontendProfile(clang::CompilerInvocation &invocation, FrontendProfile profile) {
+        if (profile != FrontendProfile::Fast) {
+            return;
+        }
+        // the generator never looks into function bodies. Clang still parses those it can't do without: bodies of constexpr
+        // functions and of functions with a deduced return type. Skipping the rest also spares instantiating whatever templates they use.
+        invocation.getFrontendOpts().SkipFunctionBodies = true;
+        invocation.getDiagnosticOpts().IgnoreWarnings = true;
+        invocation.getLangOpts()->SpellChecking = false;
+        // there's no code generation to begin with: tools only ever run -fsyntax-only actions. The target stays as it is because
+        // sizes and alignments depend on it
+    }
+
+    ActionFactory::ActionFactory(llvm::ArrayRef<ReflectionJob> Jobs, GeneratedFiles &Outputs, JobStatistics &Statistics, std::shared_ptr<DependencyListCollector> &Dependencies, const IdentifierRepository *Imports, FrontendProfile Profile, PreambleCache *Preambles, llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem)
+        :jobs(Jobs),
+         outputs(Outputs),
+         statistics(Statistics),
+         dependencies(Dependencies),
+         imports(Imports),
+         profile(Profile),
+         preambles(Preambles),
+         fileSystem(std::move(FileSystem)) {}
+
     std::unique_ptr<clang::FrontendAction> ActionFactory::create() {
-        return std::make_unique<MetadataGenerateAction>();
+        return std::make_unique<MetadataGenerateAction>(jobs, outputs, statistics, dependencies, imports);
+    }
+
+    bool ActionFactory::runInvocation(std::shared_ptr<clang::CompilerInvocation> Invocation,
+                                      clang::FileManager *Files,
+                                      std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps,
+                                      clang::DiagnosticConsumer *DiagConsumer) {
+        applyFrontendProfile(*Invocation, profile);
+        if (!preambles) {
+            return FrontendActionFactory::runInvocation(std::move(Invocation), Files, std::move(PCHContainerOps), DiagConsumer);
+        }
+
+        auto preambleFileSystem = fileSystem;
+        std::shared_ptr<const clang::PrecompiledPreamble> preamble;
+        {
+            llvm::TimeTraceScope timeScope("Preamble");
+            preamble = preambles->prepare(*Invocation, preambleFileSystem, PCHContainerOps, DiagConsumer);
+        }
+        // an in-memory preamble is only visible through the overlay prepare puts on top of the file system
+        llvm::IntrusiveRefCntPtr<clang::FileManager> preambleFiles(new clang::FileManager(Files->getFileSystemOpts(), preambleFileSystem));
+        return FrontendActionFactory::runInvocation(std::move(Invocation), preambleFiles.get(), std::move(PCHContainerOps), DiagConsumer);
+    }
+
+    MetadataGenerateAction::MetadataGenerateAction(llvm::ArrayRef<ReflectionJob> Jobs, GeneratedFiles &Outputs, JobStatistics &Statistics, std::shared_ptr<DependencyListCollector> &Dependencies, const IdentifierRepository *Imports)
+        :jobs(Jobs),
+         outputs(Outputs),
+         statistics(Statistics),
+         dependencies(Dependencies),
+         imports(Imports) {}
+
+    DependencyListCollector::DependencyListCollector(std::vector<std::string> IgnoredFiles)
+        :ignoredFiles(std::move(IgnoredFiles)) {}
+
+    bool DependencyListCollector::sawDependency(llvm::StringRef Filename, bool FromModule, bool IsSystem, bool IsModuleFile, bool IsMissing) {
+        return !IsModuleFile && !IsMissing && !isIgnored(Filename) && DependencyCollector::sawDependency(Filename, FromModule, IsSystem, IsModuleFile, IsMissing);
+    }
+
+    bool DependencyListCollector::isIgnored(llvm::StringRef Filename) const {
+        return std::find(ignoredFiles.begin(), ignoredFiles.end(), Filename) != ignoredFiles.end();
+    }
+
+    namespace {
+        // spaces, hashes and dollars mean something to make
+        std::string escapeForMake(llvm::StringRef path) {
+            std::string escaped;
+            escaped.reserve(path.size());
+            for (const char c: path) {
+                if (c == ' ' || c == '#') {
+                    escaped += '\\';
+                } else if (c == '$') {
+                    escaped += '$';
+                }
+                escaped += c;
+            }
+            return escaped;
+        }
+    }
+
+    std::string DependencyListCollector::makeRule(const std::string &target) const {
+        std::string rule = escapeForMake(target) + ':';
+        for (const auto &dependency: getDependencies()) {
+            // the reader of a precompiled preamble may report it without asking sawDependency
+            if (isIgnored(dependency)) {
+                continue;
+            }
+            rule += " \\\n  ";
+            rule += escapeForMake(dependency);
+        }
+        rule += '\n';
+        return rule;
+    }
+
+    namespace {
+        /**
+         * @return a collector attached to the preprocessor of compiler if any of jobs writes a depfile, null otherwise
+         */
+        std::shared_ptr<DependencyListCollector> collectDependencies(clang::CompilerInstance &compiler, llvm::StringRef mainFile, llvm::ArrayRef<ReflectionJob> jobs) {
+            const bool needsDependencies = std::any_of(jobs.begin(), jobs.end(), [] (const ReflectionJob &job) { return !job.depfile.empty(); });
+            if (!needsDependencies) {
+                return nullptr;
+            }
+            std::vector<std::string> ignoredFiles{compiler.getPreprocessorOpts().ImplicitPCHInclude};
+            // a main file that is none of the sources is an umbrella made up in memory, depending on it would make the outputs always out of date
+            auto &fileManager = compiler.getFileManager();
+            const auto main = fileManager.getFile(mainFile);
+            const bool mainFileIsSource = main && std::any_of(jobs.begin(), jobs.end(), [&] (const ReflectionJob &job) {
+                const auto source = fileManager.getFile(job.source);
+                return source && *source == *main;
+            });
+            if (!mainFileIsSource) {
+                ignoredFiles.push_back(mainFile.str());
+            }
+            auto dependencies = std::make_shared<DependencyListCollector>(std::move(ignoredFiles));
+            dependencies->attachToPreprocessor(compiler.getPreprocessor());
+            return dependencies;
+        }
     }
 
-    std::unique_ptr<clang::ASTConsumer> MetadataGenerateAction::CreateASTConsumer(clang::CompilerInstance &Compiler, [[maybe_unused]] llvm::StringRef InFile) {
+    std::unique_ptr<clang::ASTConsumer> MetadataGenerateAction::CreateASTConsumer(clang::CompilerInstance &Compiler, llvm::StringRef InFile) {
         compiler = &Compiler;
-        return std::make_unique<MetadataTransformingConsumer>(Compiler);
+        // the preprocessor exists already and won't look at collectors added from now on, unlike the reader of a precompiled preamble
+        dependencies = collectDependencies(Compiler, InFile, jobs);
+        if (dependencies) {
+            Compiler.addDependencyCollector(dependencies);
+        }
+        return std::make_unique<MetadataTransformingConsumer>(Compiler, jobs, outputs, statistics, imports);
     }
 
     bool MetadataGenerateAction::BeginInvocation(clang::CompilerInstance &CI) {
         return ASTFrontendAction::BeginInvocation(CI);
     }
 
-    MetadataTransformingConsumer::MetadataTransformingConsumer(clang::CompilerInstance &CI)
-        :compilerInstance(CI) {}
+    void MetadataGenerateAction::ExecuteAction() {
+        // parsing and semantic analysis, generation included as it runs once the translation unit is complete
+        llvm::TimeTraceScope timeScope("Frontend", getCurrentFile());
+        ASTFrontendAction::ExecuteAction();
+    }
+
+    MetadataTransformingConsumer::MetadataTransformingConsumer(clang::CompilerInstance &CI, llvm::ArrayRef<ReflectionJob> Jobs, GeneratedFiles &Outputs, JobStatistics &Statistics, const IdentifierRepository *Imports)
+        :compilerInstance(CI),
+         jobs(Jobs),
+         outputs(Outputs),
+         statistics(Statistics),
+         imports(Imports) {}
 
     void MetadataTransformingConsumer::HandleTranslationUnit(clang::ASTContext &context) {
-        ReflectionDataGenerator generator(compilerInstance.getASTContext(), compilerInstance.getSema());
-
         clang::PrintingPolicy ppCopy(context.getPrintingPolicy());
 
         ppCopy.SuppressUnwrittenScope = false;
         ppCopy.TerseOutput = false;
         context.setPrintingPolicy(ppCopy);
-        generator.Generate();
+
+        // one for all of the jobs of the unit, the types their headers share are only printed once
+        TypeNameCache typeNames(context.getPrintingPolicy());
+        auto &diagnostics = compilerInstance.getDiagnostics();
+        for (const auto &job: jobs) {
+            llvm::TimeTraceScope timeScope("Generate", job.source);
+            // the file manager tells files apart by their unique id, so it doesn't matter which path led to the source
+            auto file = compilerInstance.getFileManager().getFile(job.source);
+            if (!file || compilerInstance.getSourceManager().translateFile(*file).isInvalid()) {
+                diagnostics.Report(diagnostics.getCustomDiagID(clang::DiagnosticsEngine::Error, "%0 is not part of the translation unit")) << job.source;
+                continue;
+            }
+            ReflectionDataGenerator generator(context, compilerInstance.getSema(), job, *file, imports, outputs, statistics, typeNames);
+            generator.Generate();
+        }
+    }
+
+    CacheKeyAction::CacheKeyAction(const std::string &Salt, std::string &Key, llvm::ArrayRef<ReflectionJob> Jobs, std::shared_ptr<DependencyListCollector> &Dependencies)
+        :salt(Salt),
+         key(Key),
+         jobs(Jobs),
+         dependencies(Dependencies) {}
+
+    void CacheKeyAction::ExecuteAction() {
+        auto &compiler = getCompilerInstance();
+        auto &preprocessor = compiler.getPreprocessor();
+
+        llvm::MD5 hasher;
+        hasher.update(salt);
+        hasher.update(compiler.getInvocation().getModuleHash());
+
+        dependencies = collectDependencies(compiler, getCurrentFile(), jobs);
+        preprocessor.EnterMainSourceFile();
+        auto &sourceManager = compiler.getSourceManager();
+        clang::FileID tokenFile;
+        clang::Token token;
+        llvm::SmallString<256> spelling;
+        do {
+            preprocessor.Lex(token);
+            // tokens are attributed to the file they were expanded in, which is where the generator looks for declarations
+            if (const auto file = sourceManager.getFileID(sourceManager.getExpansionLoc(token.getLocation())); file != tokenFile) {
+                tokenFile = file;
+                // a byte no token spelling starts with, tokens never digest the same as a file
+                hasher.update(llvm::StringRef("\x01", 1));
+                if (const auto entry = sourceManager.getFileEntryForID(file)) {
+                    const auto realPath = entry->tryGetRealPathName();
+                    hasher.update(realPath.empty() ? entry->getName() : realPath);
+                }
+                hasher.update(llvm::StringRef("", 1));
+            }
+            if (token.isAnnotation()) {
+                hasher.update(clang::tok::getTokenName(token.getKind()));
+            } else {
+                hasher.update(preprocessor.getSpelling(token, spelling));
+            }
+            // keeps token boundaries apart, `a b` must not digest the same as `ab`
+            hasher.update(llvm::StringRef("", 1));
+        } while (token.isNot(clang::tok::eof));
+
+        llvm::MD5::MD5Result digest;
+        hasher.final(digest);
+        key = digest.digest().str().str();
+    }
+
+    CacheKeyActionFactory::CacheKeyActionFactory(std::string Salt, std::string &Key, llvm::ArrayRef<ReflectionJob> Jobs, std::shared_ptr<DependencyListCollector> &Dependencies)
+        :salt(std::move(Salt)),
+         key(Key),
+         jobs(Jobs),
+         dependencies(Dependencies) {}
+
+    std::unique_ptr<clang::FrontendAction> CacheKeyActionFactory::create() {
+        return std::make_unique<CacheKeyAction>(salt, key, jobs, dependencies);
     }
 
 }
@@ -4,42 +4,146 @@
 #pragma warning(push, 0)
 #include <clang/Tooling/Tooling.h>
 #include <clang/AST/ASTConsumer.h>
+#include <clang/Frontend/Utils.h>
 #pragma warning(pop)
 
 #include "ReflectionDataGenerator.h"
+#include "ReflectionJob.h"
+#include "PreambleCache.h"
+#include "GeneratedFiles.h"
 #include <set>
 #include <string>
 #include <memory>
+#include <vector>
 
 
 extern llvm::cl::OptionCategory mcOptionsCategory;
-extern llvm::cl::opt<std::string> mcOutput;
-extern llvm::cl::opt<std::string> mcModuleName;
-extern llvm::cl::opt<std::string> mcJsonOutput;
 
 namespace mc {
 
     class CodeGeneratorBase;
+    class DependencyListCollector;
+
+    /**
+     * @brief applyFrontendProfile tunes an invocation for profile. Nothing changes for FrontendProfile::Full.
+     */
+    void applyFrontendProfile(clang::CompilerInvocation &invocation, FrontendProfile profile);
 
     class ActionFactory : public clang::tooling::FrontendActionFactory {
     public:
+        /**
+         * @param Jobs share a single parse of the translation unit, each one reflects on the declarations of its own source. A source
+         * other than the main file must be included by it. The jobs must outlive the factory
+         * @param Dependencies receives the files the translation unit read if any of the jobs writes a depfile, left null otherwise.
+         * Depfiles are made from it by the caller, see DependencyListCollector::makeRule
+         * @param Imports if not null, the descriptors of other modules, see ReflectionDataGenerator
+         * @param Profile is applied to every invocation, before its preamble is looked up
+         * @param Preambles if not null, invocations get their preamble from it
+         * @param FileSystem the file system the tool running this factory is built on. Only needed along with Preambles
+         */
+        ActionFactory(llvm::ArrayRef<ReflectionJob> Jobs, GeneratedFiles &Outputs, JobStatistics &Statistics, std::shared_ptr<DependencyListCollector> &Dependencies, const IdentifierRepository *Imports = nullptr, FrontendProfile Profile = FrontendProfile::Full, PreambleCache *Preambles = nullptr, llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem = nullptr);
         std::unique_ptr<clang::FrontendAction> create() override;
+
+        bool runInvocation(std::shared_ptr<clang::CompilerInvocation> Invocation,
+                           clang::FileManager *Files,
+                           std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps,
+                           clang::DiagnosticConsumer *DiagConsumer) override;
+    private:
+        const llvm::ArrayRef<ReflectionJob> jobs;
+        GeneratedFiles &outputs;
+        JobStatistics &statistics;
+        std::shared_ptr<DependencyListCollector> &dependencies;
+        const IdentifierRepository *imports;
+        const FrontendProfile profile;
+        PreambleCache *preambles;
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem;
+    };
+
+    /**
+     * @brief The DependencyListCollector class records every file the compiler reads while parsing a source, system headers included.
+     * Files read through a precompiled preamble are reported by the ASTReader the preamble is loaded with.
+     */
+    class DependencyListCollector : public clang::DependencyCollector {
+    public:
+        /**
+         * @param IgnoredFiles are left out of the list. Meant for the precompiled preamble, which is no dependency of the source,
+         * and for an umbrella source that only exists in memory
+         */
+        explicit DependencyListCollector(std::vector<std::string> IgnoredFiles);
+
+        bool needSystemDependencies() override { return true; }
+        bool sawDependency(llvm::StringRef Filename, bool FromModule, bool IsSystem, bool IsModuleFile, bool IsMissing) override;
+
+        /**
+         * @return a Make style rule for target depending on every file collected
+         */
+        std::string makeRule(const std::string &target) const;
+    private:
+        bool isIgnored(llvm::StringRef Filename) const;
+
+        const std::vector<std::string> ignoredFiles;
     };
 
     class MetadataGenerateAction : public clang::ASTFrontendAction {
     public:
+        MetadataGenerateAction(llvm::ArrayRef<ReflectionJob> Jobs, GeneratedFiles &Outputs, JobStatistics &Statistics, std::shared_ptr<DependencyListCollector> &Dependencies, const IdentifierRepository *Imports);
         virtual std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance &Compiler, llvm::StringRef InFile);
         virtual bool BeginInvocation(clang::CompilerInstance &CI);
+        void ExecuteAction() override;
     private:
         clang::CompilerInstance *compiler = nullptr;
+        const llvm::ArrayRef<ReflectionJob> jobs;
+        GeneratedFiles &outputs;
+        JobStatistics &statistics;
+        std::shared_ptr<DependencyListCollector> &dependencies;
+        const IdentifierRepository *imports;
     };
 
     class MetadataTransformingConsumer : public clang::ASTConsumer {
     public:
-        MetadataTransformingConsumer(clang::CompilerInstance &CI);
+        MetadataTransformingConsumer(clang::CompilerInstance &CI, llvm::ArrayRef<ReflectionJob> Jobs, GeneratedFiles &Outputs, JobStatistics &Statistics, const IdentifierRepository *Imports);
         virtual void HandleTranslationUnit(clang::ASTContext &Context);
     private:
         clang::CompilerInstance &compilerInstance;
+        const llvm::ArrayRef<ReflectionJob> jobs;
+        GeneratedFiles &outputs;
+        JobStatistics &statistics;
+        const IdentifierRepository *imports;
+    };
+
+    /**
+     * @brief The CacheKeyAction class only preprocesses its source and digests the resulting tokens, along with the path of the file
+     * each of them comes from and the compiler options that matter to the meaning of the code. Edits that don't change the preprocessed
+     * source, such as comments, keep the same key. Moving a declaration to another file doesn't, as only the declarations of its own
+     * source make it into the outputs of a job.
+     */
+    class CacheKeyAction : public clang::PreprocessorFrontendAction {
+    public:
+        /**
+         * @param Salt is digested along with the source. It should cover everything else the outputs depend on
+         * @param Key receives the hex digest
+         * @param Jobs run on the source, the files it includes are collected if any of them writes a depfile
+         * @param Dependencies receives what was collected, left null otherwise. Depfiles are made from it rather than cached
+         */
+        CacheKeyAction(const std::string &Salt, std::string &Key, llvm::ArrayRef<ReflectionJob> Jobs, std::shared_ptr<DependencyListCollector> &Dependencies);
+    protected:
+        void ExecuteAction() override;
+    private:
+        const std::string &salt;
+        std::string &key;
+        const llvm::ArrayRef<ReflectionJob> jobs;
+        std::shared_ptr<DependencyListCollector> &dependencies;
+    };
+
+    class CacheKeyActionFactory : public clang::tooling::FrontendActionFactory {
+    public:
+        CacheKeyActionFactory(std::string Salt, std::string &Key, llvm::ArrayRef<ReflectionJob> Jobs, std::shared_ptr<DependencyListCollector> &Dependencies);
+        std::unique_ptr<clang::FrontendAction> create() override;
+    private:
+        const std::string salt;
+        std::string &key;
+        const llvm::ArrayRef<ReflectionJob> jobs;
+        std::shared_ptr<DependencyListCollector> &dependencies;
     };
 }
 
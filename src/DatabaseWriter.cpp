@@ -0,0 +1,149 @@
+#include "DatabaseWriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mc {
+
+    namespace {
+        class StringTable {
+        public:
+            rosewood::db::StringRef add(std::string_view string) {
+                auto [position, added] = offsets.try_emplace(std::string(string), static_cast<std::uint32_t>(contents.size()));
+                if (added) {
+                    contents.append(string);
+                    contents.push_back('\0');
+                }
+                return rosewood::db::StringRef{position->second, static_cast<std::uint32_t>(string.size())};
+            }
+
+            const std::string &data() const { return contents; }
+
+        private:
+            std::string contents;
+            std::unordered_map<std::string, std::uint32_t> offsets;
+        };
+
+        rosewood::db::Section appendSection(std::string &file, const void *data, std::size_t count, std::size_t recordSize) {
+            file.resize((file.size() + 7) & ~std::size_t(7), '\0');
+            const rosewood::db::Section section{static_cast<std::uint32_t>(file.size()), static_cast<std::uint32_t>(count)};
+            file.append(static_cast<const char*>(data), count * recordSize);
+            return section;
+        }
+
+        template <typename Record>
+        rosewood::db::Section appendSection(std::string &file, const std::vector<Record> &records) {
+            return appendSection(file, records.data(), records.size(), sizeof(Record));
+        }
+    }
+
+    DatabaseWriter::DatabaseWriter(std::string_view moduleName) {
+        declarations.push_back(Declaration{rosewood::db::DeclarationKind::Module, std::string(moduleName), std::string(), rosewood::db::none, rosewood::db::none, {}, {}});
+    }
+
+    DatabaseWriter::Index DatabaseWriter::addDeclaration(Index parent, rosewood::db::DeclarationKind kind, std::string_view name, Index type) {
+        const auto &parentDeclaration = declarations[parent];
+        std::string qualifiedName = parent == root ? std::string(name) : parentDeclaration.qualifiedName + "::" + std::string(name);
+        const auto index = static_cast<Index>(declarations.size());
+        declarations.push_back(Declaration{kind, std::string(name), std::move(qualifiedName), parent, type, {}, {}});
+        declarations[parent].declarations.push_back(index);
+        return index;
+    }
+
+    DatabaseWriter::Index DatabaseWriter::addMember(Index parent, rosewood::db::MemberKind kind, std::string_view name, Index type, std::int64_t value, std::uint32_t flags) {
+        const auto index = static_cast<Index>(members.size());
+        members.push_back(Member{kind, std::string(name), parent, type, value, flags, {}});
+        declarations[parent].members.push_back(index);
+        return index;
+    }
+
+    void DatabaseWriter::addParameter(Index member, std::string_view name, Index type, std::uint32_t flags) {
+        members[member].parameters.push_back(Parameter{std::string(name), type, flags});
+    }
+
+    DatabaseWriter::Index DatabaseWriter::addType(std::string_view name, std::string_view canonicalName, std::string_view atomicName) {
+        std::string key;
+        key.reserve(name.size() + canonicalName.size() + atomicName.size() + 2);
+        key.append(name).append(1, '\0').append(canonicalName).append(1, '\0').append(atomicName);
+        auto [position, added] = typeIndices.try_emplace(std::move(key), static_cast<Index>(types.size()));
+        if (added) {
+            types.push_back(Type{std::string(name), std::string(canonicalName), std::string(atomicName)});
+        }
+        return position->second;
+    }
+
+    std::string DatabaseWriter::serialize() const {
+        StringTable strings;
+
+        // breadth first, so that the nested declarations of every declaration end up next to each other
+        std::vector<Index> order{root};
+        std::vector<Index> newIndex(declarations.size(), rosewood::db::none);
+        newIndex[root] = 0;
+        std::vector<rosewood::db::DeclarationRecord> declarationRecords;
+        std::vector<rosewood::db::MemberRecord> memberRecords;
+        std::vector<rosewood::db::ParameterRecord> parameterRecords;
+
+        auto byName = [] (const auto &entities) {
+            return [&entities] (Index lhs, Index rhs) { return entities[lhs].name < entities[rhs].name; };
+        };
+
+        for (std::size_t position(0); position < order.size(); ++position) {
+            const auto &declaration = declarations[order[position]];
+
+            std::vector<Index> nested = declaration.declarations;
+            std::stable_sort(nested.begin(), nested.end(), byName(declarations));
+            const auto firstDeclaration = static_cast<std::uint32_t>(order.size());
+            for (const auto child: nested) {
+                newIndex[child] = static_cast<Index>(order.size());
+                order.push_back(child);
+            }
+
+            // overloads stay in declaration order
+            std::vector<Index> ownMembers = declaration.members;
+            std::stable_sort(ownMembers.begin(), ownMembers.end(), byName(members));
+            const auto firstMember = static_cast<std::uint32_t>(memberRecords.size());
+            for (const auto memberIndex: ownMembers) {
+                const auto &member = members[memberIndex];
+                const auto firstParameter = static_cast<std::uint32_t>(parameterRecords.size());
+                for (const auto &parameter: member.parameters) {
+                    parameterRecords.push_back(rosewood::db::ParameterRecord{strings.add(parameter.name), parameter.type, parameter.flags});
+                }
+                memberRecords.push_back(rosewood::db::MemberRecord{member.value, member.kind, member.flags, strings.add(member.name), static_cast<std::uint32_t>(position),
+                                                                   member.type, firstParameter, static_cast<std::uint32_t>(member.parameters.size())});
+            }
+
+            declarationRecords.push_back(rosewood::db::DeclarationRecord{
+                declaration.kind,
+                strings.add(declaration.name),
+                strings.add(declaration.qualifiedName),
+                declaration.parent == rosewood::db::none ? rosewood::db::none : newIndex[declaration.parent],
+                declaration.type,
+                firstDeclaration,
+                static_cast<std::uint32_t>(nested.size()),
+                firstMember,
+                static_cast<std::uint32_t>(ownMembers.size())
+            });
+        }
+
+        std::vector<rosewood::db::TypeRecord> typeRecords;
+        typeRecords.reserve(types.size());
+        for (const auto &type: types) {
+            typeRecords.push_back(rosewood::db::TypeRecord{strings.add(type.name), strings.add(type.canonicalName), strings.add(type.atomicName)});
+        }
+
+        rosewood::db::FileHeader header{};
+        std::memcpy(header.magic, rosewood::db::magic, sizeof(header.magic));
+        header.version = rosewood::db::version;
+        header.byteOrder = rosewood::db::byteOrder;
+
+        std::string file(sizeof(header), '\0');
+        header.declarations = appendSection(file, declarationRecords);
+        header.members = appendSection(file, memberRecords);
+        header.parameters = appendSection(file, parameterRecords);
+        header.types = appendSection(file, typeRecords);
+        header.strings = appendSection(file, strings.data().data(), strings.data().size(), 1);
+        std::memcpy(file.data(), &header, sizeof(header));
+        return file;
+    }
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <rosewood/database.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mc {
+
+    /**
+     * @brief The DatabaseWriter class collects the declarations of a module as they are exported and lays them out as a reflection
+     * database, see rosewood/database.hpp. Declarations may be added in any order, serialize sorts them the way the runtime looks them up.
+     */
+    class DatabaseWriter {
+    public:
+        using Index = std::uint32_t;
+        // the module, parent of the top level declarations
+        static constexpr Index root = 0;
+
+        explicit DatabaseWriter(std::string_view moduleName);
+
+        /**
+         * @param type the class itself for classes, the underlying type for enums, rosewood::db::none otherwise
+         */
+        Index addDeclaration(Index parent, rosewood::db::DeclarationKind kind, std::string_view name, Index type = rosewood::db::none);
+        Index addMember(Index parent, rosewood::db::MemberKind kind, std::string_view name, Index type = rosewood::db::none, std::int64_t value = 0, std::uint32_t flags = 0);
+        void addParameter(Index member, std::string_view name, Index type, std::uint32_t flags = 0);
+        /**
+         * @return the index of the type with these names, added if it's the first time they're seen
+         */
+        Index addType(std::string_view name, std::string_view canonicalName, std::string_view atomicName);
+
+        std::string serialize() const;
+
+    private:
+        struct Declaration {
+            rosewood::db::DeclarationKind kind;
+            std::string name;
+            std::string qualifiedName;
+            Index parent;
+            Index type;
+            std::vector<Index> declarations;
+            std::vector<Index> members;
+        };
+
+        struct Parameter {
+            std::string name;
+            Index type;
+            std::uint32_t flags;
+        };
+
+        struct Member {
+            rosewood::db::MemberKind kind;
+            std::string name;
+            Index parent;
+            Index type;
+            std::int64_t value;
+            std::uint32_t flags;
+            std::vector<Parameter> parameters;
+        };
+
+        struct Type {
+            std::string name;
+            std::string canonicalName;
+            std::string atomicName;
+        };
+
+        std::vector<Declaration> declarations;
+        std::vector<Member> members;
+        std::vector<Type> types;
+        std::unordered_map<std::string, Index> typeIndices;
+    };
+
+}
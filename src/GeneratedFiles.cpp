@@ -0,0 +1,143 @@
+#include "GeneratedFiles.h"
+
+#pragma warning(push, 0)
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#pragma warning(pop)
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+
+namespace mc {
+
+    namespace {
+        constexpr std::string_view serializationHeader = "rwc-generated-files 1\n";
+
+        std::optional<std::string> readFile(const std::string &path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                return std::nullopt;
+            }
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+    }
+
+    bool writeFileIfChanged(const std::string &path, std::string_view contents) {
+        if (auto existing = readFile(path); existing && *existing == contents) {
+            return true;
+        }
+
+        // declaration headers go to a directory of their own, see ReflectionJob::declarationDirectory
+        if (const auto directory = llvm::sys::path::parent_path(path); !directory.empty() && llvm::sys::fs::create_directories(directory)) {
+            return false;
+        }
+
+        // unique so that concurrent jobs, possibly of different processes, writing the same cache entry don't clash
+        int fd;
+        llvm::SmallString<256> temporaryPath;
+        if (llvm::sys::fs::createUniqueFile(path + ".%%%%%%%%.tmp", fd, temporaryPath)) {
+            return false;
+        }
+        {
+            llvm::raw_fd_ostream file(fd, true);
+            // contents are complete already, buffering them again would only cost a copy
+            file.SetUnbuffered();
+            file.write(contents.data(), contents.size());
+            file.close();
+            if (file.has_error()) {
+                file.clear_error();
+                llvm::sys::fs::remove(temporaryPath);
+                return false;
+            }
+        }
+        if (llvm::sys::fs::rename(temporaryPath, path)) {
+            llvm::sys::fs::remove(temporaryPath);
+            return false;
+        }
+        return true;
+    }
+
+    void GeneratedFiles::add(std::string path, std::string contents) {
+        files.emplace_back(std::move(path), std::move(contents));
+    }
+
+    void GeneratedFiles::remove(std::string_view path) {
+        files.erase(std::remove_if(files.begin(), files.end(), [path] (const auto &file) { return file.first == path; }), files.end());
+    }
+
+    bool GeneratedFiles::commit() const {
+        bool success = true;
+        for (const auto &[path, contents]: files) {
+            if (!writeFileIfChanged(path, contents)) {
+                fmt::print(stderr, "rwc: could not write {}\n", path);
+                success = false;
+            }
+        }
+        return success;
+    }
+
+    bool GeneratedFiles::removeOthers(const std::string &directory, std::string_view extension) const {
+        std::set<std::string, std::less<>> own;
+        for (const auto &file: files) {
+            if (llvm::sys::path::parent_path(file.first) == directory) {
+                own.insert(llvm::sys::path::filename(file.first).str());
+            }
+        }
+
+        bool success = true;
+        std::error_code error;
+        for (llvm::sys::fs::directory_iterator entry(directory, error), end; entry != end && !error; entry.increment(error)) {
+            const auto filename = llvm::sys::path::filename(entry->path());
+            const std::string_view name(filename.data(), filename.size());
+            const bool stale = name.size() > extension.size() && name.substr(name.size() - extension.size()) == extension && own.find(name) == own.end();
+            if (stale && llvm::sys::fs::remove(entry->path())) {
+                fmt::print(stderr, "rwc: could not remove {}\n", entry->path());
+                success = false;
+            }
+        }
+        return success;
+    }
+
+    std::string GeneratedFiles::serialize() const {
+        // every file is a line holding the sizes of its path and contents followed by the path and contents themselves
+        std::string data(serializationHeader);
+        for (const auto &[path, contents]: files) {
+            data += fmt::format("{} {}\n", path.size(), contents.size());
+            data += path;
+            data += contents;
+        }
+        return data;
+    }
+
+    std::optional<GeneratedFiles> GeneratedFiles::deserialize(std::string_view data) {
+        if (data.substr(0, serializationHeader.size()) != serializationHeader) {
+            return std::nullopt;
+        }
+        data.remove_prefix(serializationHeader.size());
+
+        GeneratedFiles result;
+        while (!data.empty()) {
+            std::size_t pathSize, contentsSize;
+            int sizesLength = 0;
+            const std::string sizesLine(data.substr(0, data.find('\n') + 1));
+            if (std::sscanf(sizesLine.c_str(), "%zu %zu\n%n", &pathSize, &contentsSize, &sizesLength) != 2 || sizesLength == 0) {
+                return std::nullopt;
+            }
+            data.remove_prefix(static_cast<std::size_t>(sizesLength));
+            if (data.size() < pathSize + contentsSize) {
+                return std::nullopt;
+            }
+            result.add(std::string(data.substr(0, pathSize)), std::string(data.substr(pathSize, contentsSize)));
+            data.remove_prefix(pathSize + contentsSize);
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mc {
+
+    /**
+     * @brief writeFileIfChanged replaces the contents of a file unless it already holds exactly contents. An untouched file keeps its
+     * modification time so nothing depending on it gets rebuilt. Writes go through a temporary file so readers never see half a file.
+     * Missing parent directories are created.
+     * @return false if the file could not be written
+     */
+    bool writeFileIfChanged(const std::string &path, std::string_view contents);
+
+    /**
+     * @brief The GeneratedFiles class collects the outputs of a job so they can be written once the job succeeded, and cached.
+     */
+    class GeneratedFiles {
+    public:
+        void add(std::string path, std::string contents);
+        void remove(std::string_view path);
+
+        /**
+         * @brief commit writes every file that changed, see writeFileIfChanged
+         * @return false if any of the files could not be written
+         */
+        bool commit() const;
+
+        /**
+         * @brief removeOthers removes the files of directory named with extension that aren't among these files, such as the headers of
+         * declarations that are gone since an earlier run
+         * @return false if any of them could not be removed
+         */
+        bool removeOthers(const std::string &directory, std::string_view extension) const;
+
+        std::string serialize() const;
+        static std::optional<GeneratedFiles> deserialize(std::string_view data);
+
+    private:
+        std::vector<std::pair<std::string, std::string>> files;
+    };
+
+}
@@ -224,4 +224,18 @@ namespace mc {
         os << replaceIllegalIdentifierChars(tos.str().str());
         return fmt::format("{}{}", prefix, os.str());
     }
+
+    const std::string &TypeNameCache::name(clang::QualType type) {
+        ++lookupCount;
+        auto res = names.find(type.getAsOpaquePtr());
+        if (res == names.end()) {
+            res = names.emplace(type.getAsOpaquePtr(), type.getAsString(policy)).first;
+        }
+        return res->second;
+    }
+
+    const std::string &TypeNameCache::canonicalName(clang::QualType type) {
+        return name(type.getCanonicalType());
+    }
+
 }
@@ -32,6 +32,7 @@ namespace clang {
 #include <string_view>
 #include <string>
 #include <map>
+#include <unordered_map>
 
 namespace mc {
 std::string replaceIllegalIdentifierChars(std::string_view name);
@@ -73,5 +74,30 @@ const constexpr std::string_view g_Decl_Prefix = "__metal__Decl__";
         const clang::PrintingPolicy& printingPolicy;
         // std::string outJson;
     };
+
+    /**
+     * @brief The TypeNameCache class prints every distinct type once per translation unit. The ASTContext uniques types, so the opaque
+     * pointer of a QualType, qualifiers included, is all it takes to tell whether a type was printed before.
+     * The policy is held by reference and must not change once names have been printed.
+     */
+    class TypeNameCache {
+    public:
+        explicit TypeNameCache(const clang::PrintingPolicy &Policy)
+            :policy(Policy) {}
+
+        /**
+         * @return the name of type as printed with the policy of the cache. The reference is valid for as long as the cache is
+         */
+        const std::string &name(clang::QualType type);
+        const std::string &canonicalName(clang::QualType type);
+
+        std::size_t lookups() const { return lookupCount; }
+        std::size_t hits() const { return lookupCount - names.size(); }
+
+    private:
+        std::unordered_map<const void*, std::string> names;
+        const clang::PrintingPolicy &policy;
+        std::size_t lookupCount = 0;
+    };
 }
 
@@ -4,30 +4,102 @@
 #pragma warning(pop)
 
 #include <fstream>
-#include <iomanip>
-// #include <nlohmann/json.hpp>
+#include <iterator>
 
 namespace mc {
 
-IdentifierRepository::IdentifierRepository(const fs::path &source) {
-    // nlohmann::json json;
-    // json.parse(std::ifstream(source));
-    // TDO definedIdents = json["defined"];
-}
+    namespace {
+        constexpr std::string_view repositoryHeader = "rosewood-identifiers 1\n";
+        constexpr std::string_view defineTag = "define\t";
+        constexpr std::string_view expectTag = "expect\t";
+
+        // splits off the text up to the next separator, or all of it if there is none
+        std::string_view nextField(std::string_view &text, char separator) {
+            const auto end = text.find(separator);
+            const auto field = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            return field;
+        }
+    }
+
+    std::optional<IdentifierRepository> IdentifierRepository::load(const fs::path &source) {
+        std::ifstream file(source, std::ios::binary);
+        if (!file) {
+            return std::nullopt;
+        }
+        const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return deserialize(data);
+    }
+
+    std::optional<IdentifierRepository> IdentifierRepository::deserialize(std::string_view data) {
+        if (data.substr(0, repositoryHeader.size()) != repositoryHeader) {
+            return std::nullopt;
+        }
+        data.remove_prefix(repositoryHeader.size());
+
+        // one identifier per line: define<TAB>identifier<TAB>descriptor<TAB>header or expect<TAB>identifier
+        IdentifierRepository repository;
+        while (!data.empty()) {
+            auto line = nextField(data, '\n');
+            if (line.substr(0, defineTag.size()) == defineTag) {
+                line.remove_prefix(defineTag.size());
+                const auto identifier = nextField(line, '\t');
+                const auto descriptor = nextField(line, '\t');
+                if (identifier.empty() || descriptor.empty() || line.empty()) {
+                    return std::nullopt;
+                }
+                repository.defineIdentifier(std::string(identifier), std::string(descriptor), std::string(line));
+            } else if (line.substr(0, expectTag.size()) == expectTag) {
+                line.remove_prefix(expectTag.size());
+                repository.expectExternalIdentifier(std::string(line));
+            } else {
+                return std::nullopt;
+            }
+        }
+        return repository;
+    }
+
+    std::string IdentifierRepository::serialize() const {
+        std::string data(repositoryHeader);
+        for (const auto &identifier: definedIdents) {
+            const auto &info = identifierMap.at(identifier);
+            data.append(defineTag).append(identifier).append(1, '\t').append(info.name).append(1, '\t').append(info.header).append(1, '\n');
+        }
+        for (const auto &identifier: externalIdents) {
+            data.append(expectTag).append(identifier).append(1, '\n');
+        }
+        return data;
+    }
 
-    void IdentifierRepository::save(const fs::path &file) {
-        // nlohmann::json json;
-        // json["defines"] = definedIdents;
-        // json["expects"] = externalIdents;
-        // std::ofstream(file) << std::setw(4) << json;
+    std::string IdentifierRepository::fingerprint() const {
+        std::string data;
+        for (const auto &[identifier, info]: identifierMap) {
+            data.append(identifier).append(1, '\t').append(info.name).append(1, '\t').append(info.header).append(1, '\n');
+        }
+        return data;
+    }
+
+    void IdentifierRepository::import(const IdentifierRepository &dependency) {
+        for (const auto &identifier: dependency.definedIdents) {
+            auto info = dependency.identifierMap.at(identifier);
+            info.defined = false;
+            // the first module to define an identifier keeps it
+            identifierMap.emplace(identifier, std::move(info));
+        }
     }
 
     bool IdentifierRepository::isDefined([[maybe_unused]] const std::string &identifier) const {
         return definedIdents.find(identifier) != definedIdents.end();
     }
 
-    void IdentifierRepository::defineIdentifier(const std::string &identifier) {
+    const IdentifierInfo *IdentifierRepository::find(const std::string &identifier) const {
+        const auto res = identifierMap.find(identifier);
+        return res != identifierMap.end() ? &res->second : nullptr;
+    }
+
+    void IdentifierRepository::defineIdentifier(const std::string &identifier, const std::string &descriptor, const std::string &header) {
         definedIdents.insert(identifier);
+        identifierMap[identifier] = IdentifierInfo{descriptor, header, true};
     }
 
     void IdentifierRepository::expectExternalIdentifier(const std::string &identifier) {
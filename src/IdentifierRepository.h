@@ -4,7 +4,9 @@
 
 #pragma warning(pop)
 
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
@@ -14,22 +16,50 @@ namespace mc {
     namespace fs = std::experimental::filesystem;
 
     struct IdentifierInfo {
+        // the fully qualified descriptor generated for the identifier
         std::string name;
+        // the generated header that defines the descriptor
+        std::string header;
+        // by this module, as opposed to one it imports
         bool defined = false;
     };
 
     /**
-     * @brief The IdentifierRepository class has a purpose but it's still an abstract concept: must keep track of what a module exports and write that data to a json.
+     * @brief The IdentifierRepository class keeps track of the descriptors a module exports, identified by the name of the type they
+     * describe, and of the ones it refers to in other modules. A module saves its repository next to its outputs so that the modules
+     * depending on it can import it and refer to its descriptors instead of generating them again.
      */
     class IdentifierRepository {
     public: 
-        explicit IdentifierRepository(const fs::path &source);
         IdentifierRepository() = default;
 
-        void save(const fs::path &file);
+        /**
+         * @brief load reads a repository written by serialize
+         * @return nothing if the file can't be read or isn't a repository
+         */
+        static std::optional<IdentifierRepository> load(const fs::path &source);
+        static std::optional<IdentifierRepository> deserialize(std::string_view data);
+        /**
+         * @return the identifiers defined by this module and the ones it expects from others, imported definitions are left out
+         */
+        std::string serialize() const;
+        /**
+         * @return every identifier known to the repository along with its descriptor, imported ones included. Two repositories with
+         * the same fingerprint lead to the same generated code
+         */
+        std::string fingerprint() const;
+
+        /**
+         * @brief import makes the definitions of dependency known to this repository. They aren't considered defined by it
+         */
+        void import(const IdentifierRepository &dependency);
 
         bool isDefined(const std::string &identifier) const;
-        void defineIdentifier(const std::string &identifier);
+        /**
+         * @return the identifier if it was defined or imported, null otherwise
+         */
+        const IdentifierInfo *find(const std::string &identifier) const;
+        void defineIdentifier(const std::string &identifier, const std::string &descriptor, const std::string &header);
         void expectExternalIdentifier(const std::string &identifier);
 
     private:
@@ -40,4 +70,3 @@ namespace mc {
     };
 
 }
-
@@ -0,0 +1,333 @@
+#include "JobRunner.h"
+#include "ClangInfrastructure.h"
+#include "OutputCache.h"
+#include "IdentifierRepository.h"
+
+#pragma warning(push, 0)
+#include <clang/Tooling/Tooling.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#pragma warning(pop)
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace mc {
+
+    namespace {
+
+        // the version alone doesn't tell development builds of rwc apart, the executable itself does
+        const std::string &toolIdentity() {
+            static const std::string identity = [] {
+                const std::string executable = llvm::sys::fs::getMainExecutable(nullptr, reinterpret_cast<void*>(&toolIdentity));
+                llvm::sys::fs::file_status status;
+                llvm::sys::fs::status(executable, status);
+                return fmt::format("rwc {} {} {}", RWC_VERSION, status.getLastModificationTime().time_since_epoch().count(), status.getSize());
+            }();
+            return identity;
+        }
+
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> createFileSystem(const JobEnvironment &environment) {
+            // the real file system shared by default ties its working directory to the process one, which tools running
+            // on other threads would then fight over. A private physical file system keeps the working directory per tool.
+            llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem(llvm::vfs::createPhysicalFileSystem().release());
+            if (!environment.workingDirectory.empty()) {
+                fileSystem->setCurrentWorkingDirectory(environment.workingDirectory);
+            }
+            return fileSystem;
+        }
+
+        /**
+         * Profiles the calling thread for as long as it lives, then writes the trace to path. Does nothing given an empty path.
+         * The profiler is thread local so jobs running on other threads don't get in each other's traces.
+         */
+        class ThreadTimeTrace {
+        public:
+            ThreadTimeTrace(std::string Path, unsigned granularity)
+                :path(std::move(Path)) {
+                if (!path.empty()) {
+                    llvm::timeTraceProfilerInitialize(granularity, "rwc");
+                }
+            }
+
+            ThreadTimeTrace(const ThreadTimeTrace &) = delete;
+            ThreadTimeTrace& operator=(const ThreadTimeTrace &) = delete;
+
+            ~ThreadTimeTrace() {
+                if (path.empty()) {
+                    return;
+                }
+                std::error_code error;
+                llvm::raw_fd_ostream file(path, error, llvm::sys::fs::OF_Text);
+                if (error) {
+                    fmt::print(stderr, "rwc: could not write {}: {}\n", path, error.message());
+                } else {
+                    llvm::timeTraceProfilerWrite(file);
+                }
+                llvm::timeTraceProfilerCleanup();
+            }
+
+        private:
+            const std::string path;
+        };
+
+        /**
+         * Answers for an umbrella source with the compile command of one of the sources it includes, the rest goes to the wrapped database.
+         */
+        class UmbrellaCompilationDatabase : public clang::tooling::CompilationDatabase {
+        public:
+            UmbrellaCompilationDatabase(const clang::tooling::CompilationDatabase &Base, std::string Umbrella, std::string Representative)
+                :base(Base),
+                 umbrella(std::move(Umbrella)),
+                 representative(std::move(Representative)) {}
+
+            std::vector<clang::tooling::CompileCommand> getCompileCommands(llvm::StringRef FilePath) const override {
+                if (FilePath != umbrella) {
+                    return base.getCompileCommands(FilePath);
+                }
+                auto commands = base.getCompileCommands(representative);
+                for (auto &command: commands) {
+                    std::replace(command.CommandLine.begin(), command.CommandLine.end(), command.Filename, umbrella);
+                    command.Filename = umbrella;
+                }
+                return commands;
+            }
+
+        private:
+            const clang::tooling::CompilationDatabase &base;
+            const std::string umbrella;
+            const std::string representative;
+        };
+
+        /**
+         * Writes the outputs of jobs. Their declaration directories hold nothing but what they generate, so the headers of declarations
+         * that are gone since an earlier run are removed as well.
+         */
+        bool commitOutputs(const GeneratedFiles &outputs, llvm::ArrayRef<ReflectionJob> jobs) {
+            bool success = outputs.commit();
+            for (const auto &job: jobs) {
+                if (!job.declarationDirectory.empty()) {
+                    success = outputs.removeOthers(job.declarationDirectory, ".h") && success;
+                }
+            }
+            return success;
+        }
+
+        /**
+         * Adds the depfile of every job that writes one to outputs. A translation unit shared by several jobs makes each of them depend on
+         * everything it read. With a unitSource, which the jobs write depfiles for, `<unitSource>.d` gets a rule of its own naming the
+         * unit, for build systems that run all of the jobs as one command.
+         */
+        void addDepfiles(GeneratedFiles &outputs, llvm::ArrayRef<ReflectionJob> jobs, const std::string &unitSource, const DependencyListCollector &dependencies) {
+            for (const auto &job: jobs) {
+                if (!job.depfile.empty()) {
+                    outputs.add(job.depfile, dependencies.makeRule(job.output));
+                }
+            }
+            if (!unitSource.empty()) {
+                outputs.add(unitSource + ".d", dependencies.makeRule(unitSource));
+            }
+        }
+
+        /**
+         * Parses mainSource once and runs every job on it, see runReflectionJob.
+         * @param outputs may already hold files of its own, they are written and cached along with the ones of the jobs
+         * @param unitSource the source written by runUmbrellaJob, empty otherwise
+         * @param tracePath where to write the trace of the run with JobEnvironment::timeTrace
+         */
+        int runJobs(const clang::tooling::CompilationDatabase &compilations, const std::string &mainSource, llvm::ArrayRef<ReflectionJob> jobs, GeneratedFiles outputs, const std::string &unitSource,
+                    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem, const std::string &tracePath, const JobEnvironment &environment, std::string *diagnostics) {
+            clang::tooling::ClangTool tool(compilations, {mainSource}, std::make_shared<clang::PCHContainerOperations>(), fileSystem);
+
+            std::unique_ptr<llvm::raw_string_ostream> diagnosticsStream;
+            std::unique_ptr<clang::TextDiagnosticPrinter> diagnosticsPrinter;
+            if (diagnostics) {
+                diagnosticsStream = std::make_unique<llvm::raw_string_ostream>(*diagnostics);
+                diagnosticsPrinter = std::make_unique<clang::TextDiagnosticPrinter>(*diagnosticsStream, new clang::DiagnosticOptions());
+                tool.setDiagnosticConsumer(diagnosticsPrinter.get());
+            }
+
+            ThreadTimeTrace timeTrace(environment.timeTrace ? tracePath : std::string(), environment.timeTraceGranularity);
+            const int result = [&] () {
+                llvm::TimeTraceScope jobScope("Job", mainSource);
+                std::string cacheKey;
+                // the files the source includes, as of now rather than of when the outputs were cached. Depfiles are made from it
+                std::shared_ptr<DependencyListCollector> dependencies;
+                if (environment.cache) {
+                    llvm::TimeTraceScope timeScope("CacheLookup");
+                    std::string salt = fmt::format("{}\n{}\n{}", toolIdentity(), static_cast<int>(environment.profile), mainSource);
+                    for (const auto &job: jobs) {
+                        salt += '\n';
+                        salt += job.fingerprint();
+                    }
+                    if (environment.imports) {
+                        salt += '\n';
+                        salt += environment.imports->fingerprint();
+                    }
+                    CacheKeyActionFactory keyFactory(salt, cacheKey, jobs, dependencies);
+                    if (const int keyResult = tool.run(&keyFactory); keyResult != 0) {
+                        return keyResult;
+                    }
+                    if (auto cached = environment.cache->load(cacheKey)) {
+                        if (dependencies) {
+                            addDepfiles(*cached, jobs, unitSource, *dependencies);
+                        }
+                        return commitOutputs(*cached, jobs) ? 0 : 1;
+                    }
+                }
+
+                JobStatistics statistics;
+                ActionFactory factory(jobs, outputs, statistics, dependencies, environment.imports, environment.profile, environment.preambles, fileSystem);
+                if (const int generateResult = tool.run(&factory); generateResult != 0) {
+                    return generateResult;
+                }
+                if (dependencies) {
+                    addDepfiles(outputs, jobs, unitSource, *dependencies);
+                }
+                if (environment.statistics) {
+                    llvm::raw_ostream &report = diagnosticsStream ? *diagnosticsStream : llvm::errs();
+                    auto reportTypeNames = [&report] (const std::string &source, std::size_t lookups, std::size_t hits) {
+                        const double hitRate = lookups ? 100. * hits / lookups : 0.;
+                        report << fmt::format("rwc: {}: {} type names looked up, {} printed, {:.1f}% cache hit rate\n", source, lookups, lookups - hits, hitRate);
+                    };
+                    for (const auto &job: statistics.jobs) {
+                        reportTypeNames(job.source, job.lookups, job.hits);
+                    }
+                    if (statistics.jobs.size() > 1) {
+                        reportTypeNames(mainSource, statistics.typeNameLookups, statistics.typeNameHits);
+                    }
+                }
+                llvm::TimeTraceScope timeScope("WriteOutputs");
+                if (!commitOutputs(outputs, jobs)) {
+                    return 1;
+                }
+                if (environment.cache) {
+                    // depfiles are made again on every hit: headers that yield no tokens, such as those guarded out, don't change the key
+                    GeneratedFiles cached = outputs;
+                    for (const auto &job: jobs) {
+                        if (!job.depfile.empty()) {
+                            cached.remove(job.depfile);
+                        }
+                    }
+                    if (!unitSource.empty()) {
+                        cached.remove(unitSource + ".d");
+                    }
+                    environment.cache->store(cacheKey, cached);
+                }
+                return 0;
+            }();
+
+            if (diagnosticsStream) {
+                diagnosticsStream->flush();
+            }
+            return result;
+        }
+
+    }
+
+    int runReflectionJob(const clang::tooling::CompilationDatabase &compilations, const ReflectionJob &job, const JobEnvironment &environment, std::string *diagnostics) {
+        return runJobs(compilations, job.source, job, GeneratedFiles(), std::string(), createFileSystem(environment), job.output + ".trace.json", environment, diagnostics);
+    }
+
+    int runUmbrellaJob(const clang::tooling::CompilationDatabase &compilations, const std::vector<ReflectionJob> &jobs, const std::string &unitSource, const JobEnvironment &environment, std::string *diagnostics) {
+        if (jobs.empty()) {
+            return 0;
+        }
+
+        llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> fileSystem(new llvm::vfs::OverlayFileSystem(createFileSystem(environment)));
+        auto absolutePath = [&fileSystem] (const std::string &path) {
+            llvm::SmallString<256> absolute(path);
+            fileSystem->makeAbsolute(absolute);
+            return absolute.str().str();
+        };
+
+        // the umbrella includes the sources, the unit includes what is generated for them
+        const std::string umbrella = absolutePath(unitSource) + ".umbrella.cpp";
+        std::string umbrellaContents = "// generated by rwc, gathers every source so that they are parsed only once\n";
+        GeneratedFiles outputs;
+        std::string unitContents = "// generated by rwc, compiles the reflection data of every source at once\n";
+        for (const auto &job: jobs) {
+            umbrellaContents += fmt::format("#include \"{}\"\n", absolutePath(job.source));
+            // a split header is included by its source
+            unitContents += fmt::format("#include \"{}\"\n", absolutePath(job.sourceOutput.empty() ? job.output : job.sourceOutput));
+        }
+        outputs.add(absolutePath(unitSource), std::move(unitContents));
+
+        llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> umbrellaFileSystem(new llvm::vfs::InMemoryFileSystem());
+        umbrellaFileSystem->addFile(umbrella, 0, llvm::MemoryBuffer::getMemBufferCopy(umbrellaContents, umbrella));
+        fileSystem->pushOverlay(umbrellaFileSystem);
+
+        const UmbrellaCompilationDatabase umbrellaCompilations(compilations, umbrella, jobs.front().source);
+        return runJobs(umbrellaCompilations, umbrella, jobs, std::move(outputs), absolutePath(unitSource), fileSystem, absolutePath(unitSource) + ".trace.json", environment, diagnostics);
+    }
+
+    ProfileComparison compareFrontendProfiles(const clang::tooling::CompilationDatabase &compilations, const ReflectionJob &job, const JobEnvironment &environment) {
+        auto fileSystem = createFileSystem(environment);
+        clang::tooling::ClangTool tool(compilations, {job.source}, std::make_shared<clang::PCHContainerOperations>(), fileSystem);
+
+        ProfileComparison comparison;
+        auto timedRun = [&] (FrontendProfile profile, GeneratedFiles &outputs, std::chrono::duration<double> &elapsed) {
+            JobStatistics statistics;
+            std::shared_ptr<DependencyListCollector> dependencies;
+            ActionFactory factory(job, outputs, statistics, dependencies, environment.imports, profile, environment.preambles, fileSystem);
+            const auto start = std::chrono::steady_clock::now();
+            const int result = tool.run(&factory);
+            elapsed = std::chrono::steady_clock::now() - start;
+            return result;
+        };
+
+        // the fast profile goes first so that it's the one paying for a cold file system cache, which keeps the measured speedup on the safe side
+        GeneratedFiles fastOutputs, fullOutputs;
+        comparison.result = timedRun(FrontendProfile::Fast, fastOutputs, comparison.fast);
+        if (const int fullResult = timedRun(FrontendProfile::Full, fullOutputs, comparison.full); fullResult != 0) {
+            comparison.result = fullResult;
+        }
+        comparison.identical = comparison.result == 0 && fastOutputs.serialize() == fullOutputs.serialize();
+        return comparison;
+    }
+
+    int runReflectionJobs(const clang::tooling::CompilationDatabase &compilations, const std::vector<ReflectionJob> &jobs, unsigned workerCount, const JobEnvironment &environment, std::vector<std::string> *diagnostics) {
+        if (workerCount == 0) {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        workerCount = static_cast<unsigned>(std::min<std::size_t>(workerCount, jobs.size()));
+
+        if (diagnostics) {
+            diagnostics->assign(jobs.size(), std::string());
+        }
+
+        std::atomic<std::size_t> nextJob(0);
+        std::atomic<int> result(0);
+
+        auto worker = [&compilations, &jobs, &environment, diagnostics, &nextJob, &result] () {
+            for (std::size_t idx = nextJob++; idx < jobs.size(); idx = nextJob++) {
+                std::string *jobDiagnostics = diagnostics ? &(*diagnostics)[idx] : nullptr;
+                if (const int jobResult = runReflectionJob(compilations, jobs[idx], environment, jobDiagnostics); jobResult != 0) {
+                    result = jobResult;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned idx(1); idx < workerCount; ++idx) {
+            workers.emplace_back(worker);
+        }
+        // the calling thread is a worker too
+        worker();
+
+        for (auto &thread: workers) {
+            thread.join();
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ReflectionJob.h"
+
+#pragma warning(push, 0)
+#include <clang/Tooling/CompilationDatabase.h>
+#pragma warning(pop)
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace mc {
+
+    class PreambleCache;
+    class OutputCache;
+    class IdentifierRepository;
+
+    /**
+     * @brief JobEnvironment holds what the jobs of one rwc invocation share beyond the compilation database.
+     */
+    struct JobEnvironment {
+        // relative sources and include paths are resolved against this directory. Empty means the working directory of the process
+        std::string workingDirectory;
+        // optional, see PreambleCache
+        PreambleCache *preambles = nullptr;
+        // optional, see OutputCache
+        OutputCache *cache = nullptr;
+        // the default of -profile as well, so that every way of running a job generates the same outputs
+        FrontendProfile profile = FrontendProfile::Full;
+        // whether to report the JobStatistics of every job along with its diagnostics
+        bool statistics = false;
+        // whether to write a Chrome trace of every job next to its output, see runReflectionJob
+        bool timeTrace = false;
+        // trace events shorter than this many microseconds are left out
+        unsigned timeTraceGranularity = 0;
+        // optional, the descriptors of the modules the jobs depend on, see ReflectionDataGenerator
+        const IdentifierRepository *imports = nullptr;
+    };
+
+    /**
+     * @brief ProfileComparison is what compareFrontendProfiles found out about a job.
+     */
+    struct ProfileComparison {
+        // 0 if both profiles succeeded
+        int result = 0;
+        std::chrono::duration<double> full{};
+        std::chrono::duration<double> fast{};
+        // whether both profiles generated the same outputs
+        bool identical = false;
+    };
+
+    /**
+     * @brief runReflectionJob parses a single source and generates its reflection data. Every call gets its own ClangTool and thus its own CompilerInstance.
+     * Outputs are only written once the job succeeded and only if their contents changed, so that whatever depends on them isn't rebuilt for nothing.
+     * With JobEnvironment::timeTrace, the phases of the job are traced into `<output>.trace.json`, along with the events clang traces by itself
+     * and one event per exported declaration. The file loads in chrome://tracing or Perfetto, like the ones of clang -ftime-trace.
+     * @param diagnostics if not null, compiler diagnostics are written to it instead of the standard error
+     * @return 0 on success, the ClangTool::run error code otherwise
+     */
+    int runReflectionJob(const clang::tooling::CompilationDatabase &compilations, const ReflectionJob &job, const JobEnvironment &environment = {}, std::string *diagnostics = nullptr);
+
+    /**
+     * @brief runUmbrellaJob reflects on every source of jobs with a single parse of an umbrella source that includes them all, so the
+     * headers they share are only parsed once. The umbrella only exists in memory and is compiled like the first source of jobs.
+     * Each job still gets its own outputs. On top of those, unitSource is written with an include of every job output, or of its source
+     * output when it has one, which makes it the one translation unit to compile the generated data with. If the jobs write depfiles, `<unitSource>.d` gets one too,
+     * naming unitSource. The trace of JobEnvironment::timeTrace goes to `<unitSource>.trace.json`.
+     * The sources must not declare the same entities in conflicting ways, since they end up in the same translation unit.
+     * @return 0 on success, the ClangTool::run error code otherwise
+     */
+    int runUmbrellaJob(const clang::tooling::CompilationDatabase &compilations, const std::vector<ReflectionJob> &jobs, const std::string &unitSource, const JobEnvironment &environment = {}, std::string *diagnostics = nullptr);
+
+    /**
+     * @brief compareFrontendProfiles runs a job with each FrontendProfile and times them. Neither the output cache nor the profile of
+     * environment are used and nothing is written, the outputs of both runs are only compared with each other.
+     */
+    ProfileComparison compareFrontendProfiles(const clang::tooling::CompilationDatabase &compilations, const ReflectionJob &job, const JobEnvironment &environment = {});
+
+    /**
+     * @brief runReflectionJobs spreads jobs over a pool of worker threads.
+     * @param workerCount the number of threads to use. 0 means one per available hardware thread.
+     * @param diagnostics if not null, receives the compiler diagnostics of every job, in the order of jobs
+     * @return 0 if every job succeeded, the error code of a failed job otherwise
+     */
+    int runReflectionJobs(const clang::tooling::CompilationDatabase &compilations, const std::vector<ReflectionJob> &jobs, unsigned workerCount, const JobEnvironment &environment = {}, std::vector<std::string> *diagnostics = nullptr);
+
+}
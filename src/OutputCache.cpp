@@ -0,0 +1,36 @@
+#include "OutputCache.h"
+
+#pragma warning(push, 0)
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#pragma warning(pop)
+
+namespace mc {
+
+    OutputCache::OutputCache(std::string Directory)
+        :directory(std::move(Directory)) {
+        llvm::sys::fs::create_directories(directory);
+    }
+
+    std::optional<GeneratedFiles> OutputCache::load(const std::string &key) const {
+        auto entry = llvm::MemoryBuffer::getFile(entryPath(key));
+        if (!entry) {
+            return std::nullopt;
+        }
+        const auto data = (*entry)->getBuffer();
+        return GeneratedFiles::deserialize(std::string_view(data.data(), data.size()));
+    }
+
+    void OutputCache::store(const std::string &key, const GeneratedFiles &files) const {
+        // a failure to cache is not a failure of the job
+        writeFileIfChanged(entryPath(key), files.serialize());
+    }
+
+    std::string OutputCache::entryPath(const std::string &key) const {
+        llvm::SmallString<256> path(directory);
+        llvm::sys::path::append(path, key + ".rwcache");
+        return path.str().str();
+    }
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "GeneratedFiles.h"
+
+#include <optional>
+#include <string>
+
+namespace mc {
+
+    /**
+     * @brief The OutputCache class stores the outputs of jobs in a directory, keyed by a digest of everything that went into them.
+     * See CacheKeyAction for how keys are computed. Entries are never evicted so the directory may be wiped at any time.
+     */
+    class OutputCache {
+    public:
+        explicit OutputCache(std::string Directory);
+
+        std::optional<GeneratedFiles> load(const std::string &key) const;
+        void store(const std::string &key, const GeneratedFiles &files) const;
+
+    private:
+        std::string entryPath(const std::string &key) const;
+
+        const std::string directory;
+    };
+
+}
@@ -0,0 +1,101 @@
+#include "PreambleCache.h"
+
+#pragma warning(push, 0)
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Lex/PreprocessorOptions.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/MemoryBuffer.h>
+#pragma warning(pop)
+
+namespace mc {
+
+    namespace {
+        // clang 12 takes the main file by reference where earlier versions took a pointer, and clang 17 asks where to store preambles that
+        // aren't kept in memory
+#if LLVM_VERSION_MAJOR >= 12
+        llvm::MemoryBufferRef mainFileOf(const llvm::MemoryBuffer &buffer) { return buffer.getMemBufferRef(); }
+        llvm::vfs::FileSystem &fileSystemOf(llvm::vfs::FileSystem &fileSystem) { return fileSystem; }
+#else
+        const llvm::MemoryBuffer *mainFileOf(const llvm::MemoryBuffer &buffer) { return &buffer; }
+        llvm::vfs::FileSystem *fileSystemOf(llvm::vfs::FileSystem &fileSystem) { return &fileSystem; }
+#endif
+    }
+
+    PreambleCache::PreambleCache(std::size_t Capacity)
+        :capacity(Capacity) {}
+
+    std::shared_ptr<const clang::PrecompiledPreamble> PreambleCache::prepare(clang::CompilerInvocation &invocation,
+                                llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> &fileSystem,
+                                std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                                clang::DiagnosticConsumer *diagConsumer) {
+        const auto &inputs = invocation.getFrontendOpts().Inputs;
+        if (inputs.size() != 1 || !inputs[0].isFile()) {
+            return nullptr;
+        }
+
+        const std::string mainFile = inputs[0].getFile().str();
+        auto mainBuffer = fileSystem->getBufferForFile(mainFile);
+        if (!mainBuffer) {
+            return nullptr;
+        }
+
+        const auto bounds = clang::ComputePreambleBounds(*invocation.getLangOpts(), mainFileOf(**mainBuffer), 0);
+        if (bounds.Size == 0) {
+            return nullptr;
+        }
+
+        // the module hash covers every option that changes the meaning of the included code: language options, macros and header search paths.
+        // Preambles built without function bodies aren't fit for full parses, see applyFrontendProfile
+        const std::string key = mainFile + '\0' + invocation.getModuleHash() + '\0' + (invocation.getFrontendOpts().SkipFunctionBodies ? "skip" : "full")
+                                + '\0' + (*mainBuffer)->getBuffer().substr(0, bounds.Size).str();
+
+        auto preamble = find(key);
+        if (!preamble || !preamble->CanReuse(invocation, mainFileOf(**mainBuffer), bounds, fileSystemOf(*fileSystem))) {
+            auto diagnostics = clang::CompilerInstance::createDiagnostics(&invocation.getDiagnosticOpts(), diagConsumer, false);
+            clang::PreambleCallbacks callbacks;
+#if LLVM_VERSION_MAJOR >= 17
+            auto built = clang::PrecompiledPreamble::Build(invocation, mainBuffer->get(), bounds, *diagnostics, fileSystem, pchContainerOps, true, "", callbacks);
+#else
+            auto built = clang::PrecompiledPreamble::Build(invocation, mainBuffer->get(), bounds, *diagnostics, fileSystem, pchContainerOps, true, callbacks);
+#endif
+            if (!built) {
+                return nullptr;
+            }
+            preamble = std::make_shared<const clang::PrecompiledPreamble>(std::move(*built));
+            insert(key, preamble);
+        }
+
+        preamble->AddImplicitPreamble(invocation, fileSystem, mainBuffer->get());
+        return preamble;
+    }
+
+    std::shared_ptr<const clang::PrecompiledPreamble> PreambleCache::find(const std::string &key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto res = preambles.find(key);
+        if (res == preambles.end()) {
+            return nullptr;
+        }
+        lru.splice(lru.begin(), lru, res->second.lruPosition);
+        return res->second.preamble;
+    }
+
+    void PreambleCache::insert(const std::string &key, std::shared_ptr<const clang::PrecompiledPreamble> preamble) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto res = preambles.find(key); res != preambles.end()) {
+            res->second.preamble = std::move(preamble);
+            lru.splice(lru.begin(), lru, res->second.lruPosition);
+            return;
+        }
+
+        lru.push_front(key);
+        preambles.emplace(key, Entry{std::move(preamble), lru.begin()});
+
+        while (preambles.size() > capacity) {
+            // jobs still using an evicted preamble hold their own reference to it, see prepare
+            preambles.erase(lru.back());
+            lru.pop_back();
+        }
+    }
+
+}
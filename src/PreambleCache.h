@@ -0,0 +1,59 @@
+#pragma once
+
+#pragma warning(push, 0)
+#include <clang/Frontend/PrecompiledPreamble.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#pragma warning(pop)
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace clang {
+    class CompilerInvocation;
+    class DiagnosticConsumer;
+    class PCHContainerOperations;
+}
+
+namespace mc {
+
+    /**
+     * @brief The PreambleCache class keeps precompiled preambles (the leading block of includes of a source) in memory so that
+     * regenerating the reflection data of a header only has to parse what follows its includes.
+     * Preambles are keyed by the source they belong to, its include prefix and the compile flags. A preamble is reused only as long as
+     * none of the files it was built from changed. Thread safe.
+     */
+    class PreambleCache {
+    public:
+        explicit PreambleCache(std::size_t Capacity);
+
+        /**
+         * @brief prepare makes invocation use a cached preamble for its main file, building one if none is usable yet.
+         * @param fileSystem gets replaced by an overlay that also provides the in-memory preamble. The file manager of the invocation must be built on top of it.
+         * Does nothing if the main file has no preamble or building one fails, in which case the invocation just parses everything.
+         * @return the preamble the invocation now refers to. It must be kept alive until the invocation is done with it.
+         */
+        std::shared_ptr<const clang::PrecompiledPreamble> prepare(clang::CompilerInvocation &invocation,
+                     llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> &fileSystem,
+                     std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                     clang::DiagnosticConsumer *diagConsumer);
+
+    private:
+        std::shared_ptr<const clang::PrecompiledPreamble> find(const std::string &key);
+        void insert(const std::string &key, std::shared_ptr<const clang::PrecompiledPreamble> preamble);
+
+        using lru_list = std::list<std::string>;
+        struct Entry {
+            std::shared_ptr<const clang::PrecompiledPreamble> preamble;
+            lru_list::iterator lruPosition;
+        };
+
+        std::mutex mutex;
+        const std::size_t capacity;
+        std::map<std::string, Entry> preambles;
+        lru_list lru; // most recently used key first
+    };
+
+}
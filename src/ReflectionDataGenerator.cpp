@@ -3,6 +3,7 @@
 #include <unordered_map>
 #include <string_view>
 #include <map>
+#include <numeric>
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 #include <experimental/filesystem>
@@ -12,48 +13,149 @@
 #include <iostream>
 
 #pragma warning(push, 0)
+#include <llvm/Support/TimeProfiler.h>
 #pragma warning(pop)
 
-extern llvm::cl::opt<std::string> mcOutput;
-extern llvm::cl::opt<std::string> mcJsonOutput;
-
 namespace mc {
     namespace fs = std::experimental::filesystem;
 
 
-    ReflectionDataGenerator::ReflectionDataGenerator(clang::ASTContext &astContext, clang::Sema &Sema)
-        :out(mcOutput),
+    ReflectionDataGenerator::ReflectionDataGenerator(clang::ASTContext &astContext, clang::Sema &Sema, const ReflectionJob &Job, const clang::FileEntry *File, const IdentifierRepository *Imports, GeneratedFiles &Outputs, JobStatistics &Statistics, TypeNameCache &TypeNames)
+        :job(Job),
+        file(File),
+        imports(Imports),
+        outputs(Outputs),
+        statistics(Statistics),
         idman(astContext.getPrintingPolicy()),
         idrepo(),
         context(astContext),
         sema(Sema),
-        printingPolicy(astContext.getPrintingPolicy()) {
+        typeNames(TypeNames),
+        typeNameLookupsBefore(TypeNames.lookups()),
+        typeNameHitsBefore(TypeNames.hits()),
+        database(Job.moduleName) {
 
         global_scope.putline("#pragma once");
+        preamblePosition = out.size();
         global_scope.putline("#include <array>");
         global_scope.putline("#include <string_view>");
 
         global_scope.putline("#include <rosewood/rosewood.hpp>");
         global_scope.putline("#include <rosewood/type.hpp>");
 
-        auto mainFile = astContext.getSourceManager().getMainFileID();
-        auto mainFileLoc = astContext.getSourceManager().getComposedLoc(mainFile, 0);
-        auto mainFilePath = astContext.getSourceManager().getFilename(mainFileLoc);
+        auto &sourceManager = astContext.getSourceManager();
+        auto reflectedFileLoc = sourceManager.getLocForStartOfFile(sourceManager.translateFile(file));
+        auto reflectedFilePath = sourceManager.getFilename(reflectedFileLoc);
 
-        global_scope.putline("#include \"{}\"", mainFilePath.str());
+        global_scope.putline("#include \"{}\"", reflectedFilePath.str());
+        importedHeadersPosition = out.size();
         global_scope.putline("");
         global_scope.putline("namespace rosewood {{");
+        bodyPosition = out.size();
+
+        if (!job.sourceOutput.empty()) {
+            scope(sourceOut, 0).putline("#include <cstddef>");
+            scope(sourceOut, 0).putline("#include \"{}\"", job.output);
+            scope(sourceOut, 0).putline("");
+            scope(sourceOut, 0).putline("namespace rosewood {{");
+        }
+    }
+
+    static void putMetaSpecializations(scope where, const std::vector<std::tuple<std::string, std::string>> &metaTypes) {
+        for(const auto &[declName, descriptorName]: metaTypes) {
+            where.putline("template <>");
+            where.putline("struct meta <{}> : public {} {{}};", declName, descriptorName);
+        }
     }
 
     ReflectionDataGenerator::~ReflectionDataGenerator() {
-        for(const auto &[declName, descriptorName]: exportedMetaTypes) {
-            global_scope.putline("template <>");
-            global_scope.putline("struct meta <{}> : public {} {{}};", declName, descriptorName);
+        if (!job.moduleInterfaceOutput.empty()) {
+            addModuleInterface(out.size());
         }
+        putMetaSpecializations(global_scope, exportedMetaTypes);
 
         global_scope.putline("}}");
-        idrepo.save(mcJsonOutput.getValue());
-        out.flush();
+
+        std::string header(out.data(), importedHeadersPosition);
+        for (const auto &importedHeader: importedHeaders) {
+            header += fmt::format("#include \"{}\"\n", importedHeader);
+        }
+        header.append(out.data() + importedHeadersPosition, out.size() - importedHeadersPosition);
+        if (job.declarationDirectory.empty()) {
+            outputs.add(job.output, std::move(header));
+        } else {
+            // the module and namespace descriptors, the declaration headers define the rest of them. The output includes them all
+            const auto moduleHeader = fmt::format("{}/module-descriptors.h", job.declarationDirectory);
+            fmt::memory_buffer umbrella;
+            scope(umbrella, 0).putline("#pragma once");
+            scope(umbrella, 0).putline("#include \"{}\"", moduleHeader);
+            // build systems can't name the declaration headers in advance, this lists them all and is only rewritten when they come or go
+            fmt::memory_buffer manifest;
+            scope(manifest, 0).putline("module-descriptors.h");
+            for (const auto &declaration: declarationHeaders) {
+                fmt::memory_buffer contents;
+                scope file(contents, 0);
+                file.putline("#pragma once");
+                file.putline("#include \"{}\"", moduleHeader);
+                for (const auto &include: declaration.includes) {
+                    file.putline("#include \"{}\"", include);
+                }
+                file.putline("");
+                file.putline("namespace rosewood {{");
+                contents.append(declaration.out.data(), declaration.out.data() + declaration.out.size());
+                putMetaSpecializations(file, declaration.metaTypes);
+                file.putline("}}");
+                outputs.add(declaration.path, fmt::to_string(contents));
+                scope(umbrella, 0).putline("#include \"{}\"", declaration.path);
+                scope(manifest, 0).putline("{}", declaration.path.substr(job.declarationDirectory.size() + 1));
+            }
+            outputs.add(moduleHeader, std::move(header));
+            outputs.add(fmt::format("{}/manifest.txt", job.declarationDirectory), fmt::to_string(manifest));
+            outputs.add(job.output, fmt::to_string(umbrella));
+        }
+        if (!job.repositoryOutput.empty()) {
+            outputs.add(job.repositoryOutput, idrepo.serialize());
+        }
+        if (!job.sourceOutput.empty()) {
+            scope(sourceOut, 0).putline("}}");
+            outputs.add(job.sourceOutput, fmt::to_string(sourceOut));
+        }
+        auto &typeNameStatistics = statistics.jobs.emplace_back();
+        typeNameStatistics.source = job.source;
+        typeNameStatistics.lookups = typeNames.lookups() - typeNameLookupsBefore;
+        typeNameStatistics.hits = typeNames.hits() - typeNameHitsBefore;
+        statistics.typeNameLookups += typeNameStatistics.lookups;
+        statistics.typeNameHits += typeNameStatistics.hits;
+        outputs.add(job.databaseOutput, database.serialize());
+    }
+
+    void ReflectionDataGenerator::addModuleInterface(std::size_t descriptorsEnd) {
+        fmt::memory_buffer contents;
+        scope unit(contents, 0);
+        // what the header includes goes to the global module fragment, the descriptors are attached to the module
+        unit.putline("module;");
+        contents.append(out.data() + preamblePosition, out.data() + importedHeadersPosition);
+        for (const auto &importedHeader: importedHeaders) {
+            unit.putline("#include \"{}\"", importedHeader);
+        }
+        unit.putline("");
+        unit.putline("export module {}.meta;", job.moduleName);
+        unit.putline("");
+        unit.putline("export namespace rosewood {{");
+        contents.append(out.data() + bodyPosition, out.data() + descriptorsEnd);
+        unit.putline("}}");
+        unit.putline("");
+        // explicit specializations and out of line definitions can't be exported, but they are reachable by every importer all the same
+        unit.putline("namespace rosewood {{");
+        for (const auto &declaration: declarationHeaders) {
+            contents.append(declaration.out.data(), declaration.out.data() + declaration.out.size());
+        }
+        putMetaSpecializations(unit, exportedMetaTypes);
+        for (const auto &declaration: declarationHeaders) {
+            putMetaSpecializations(unit, declaration.metaTypes);
+        }
+        unit.putline("}}");
+        outputs.add(job.moduleInterfaceOutput, fmt::to_string(contents));
     }
 
     template <typename declRangeT>
@@ -127,29 +229,52 @@ namespace mc {
     }
 
 
+    bool ReflectionDataGenerator::isInReflectedFile(clang::SourceLocation location) const {
+        const auto &sourceManager = context.getSourceManager();
+        return location.isValid() && sourceManager.getFileEntryForID(sourceManager.getFileID(sourceManager.getExpansionLoc(location))) == file;
+    }
+
+    DatabaseWriter::Index ReflectionDataGenerator::databaseType(clang::QualType type) {
+        return database.addType(typeNames.name(type), typeNames.canonicalName(type), typeNames.canonicalName(getUnitType(type)));
+    }
+
+    // anonymous enums are known by the name of their typedef
+    static std::string enumQualifiedName(const clang::EnumDecl *Enum) {
+        return Enum->getName().empty() ? Enum->getTypedefNameForAnonDecl()->getQualifiedNameAsString() : Enum->getQualifiedNameAsString();
+    }
+
+    static std::string enumName(const clang::EnumDecl *Enum) {
+        return Enum->getName().empty() ? Enum->getTypedefNameForAnonDecl()->getNameAsString() : Enum->getNameAsString();
+    }
+
     void ReflectionDataGenerator::Generate() {
-        printingPolicy = context.getPrintingPolicy();
-        descriptor_scope module_scope = descriptor_scope(global_scope.spawn(), mcModuleName.getValue(), "rosewood::Module");
+        descriptor_scope module_scope = descriptor_scope(global_scope.spawn(), job.moduleName, "rosewood::Module");
 
         std::vector<std::string> exportedNamespaces;
         std::vector<std::string> exportedEnums;
         std::vector<std::string> exportedClasses;
+        // the names they are declared by, for the name table
+        std::vector<std::string> namespaceNames;
+        std::vector<std::string> enumNames;
+        std::vector<std::string> classNames;
 
         for(const auto decl: context.getTranslationUnitDecl()->decls()) {
-            // first cull out everything that isn't defined within the `main` file
-            const bool inMainFile(context.getSourceManager().isInMainFile(decl->getLocation()));
-            if (inMainFile) {
+            // first cull out everything that isn't defined within the reflected file
+            if (isInReflectedFile(decl->getLocation())) {
                 switch(auto declKind = decl->getKind()) {
-                case clang::Decl::Kind::Namespace:
-                    exportedNamespaces.push_back(fmt::format("meta_{}", exportNamespace(static_cast<const clang::NamespaceDecl*>(decl), module_scope).name));
-                    break;
+                case clang::Decl::Kind::Namespace: {
+                    const auto &name = namespaceNames.emplace_back(exportNamespace(static_cast<const clang::NamespaceDecl*>(decl), module_scope).name);
+                    exportedNamespaces.push_back(fmt::format("meta_{}", name));
+                } break;
                 case clang::Decl::Kind::Enum:
-                    exportedEnums.push_back(fmt::format("meta_{}", exportEnum(static_cast<const clang::EnumDecl*>(decl), module_scope).name));
+                    exportedEnums.push_back(enumDescriptor(static_cast<const clang::EnumDecl*>(decl), module_scope));
+                    enumNames.push_back(enumName(static_cast<const clang::EnumDecl*>(decl)));
                     break;
                 case clang::Decl::Kind::CXXRecord: {
                     auto record = static_cast<const clang::CXXRecordDecl*>(decl);
                     if (record->isThisDeclarationADefinition()) {
-                        exportedClasses.push_back(fmt::format("meta_{}", exportCxxRecord(record->getNameAsString(), record, module_scope).name));
+                        exportedClasses.push_back(recordDescriptor(record->getNameAsString(), record, module_scope));
+                        classNames.push_back(record->getNameAsString());
                     }
                 } break;
                 case clang::Decl::Kind::ClassTemplateSpecialization: {
@@ -170,6 +295,7 @@ namespace mc {
         wrap_range_in_tuple("namespaces", module_scope.inner, exportedNamespaces);
         wrap_range_in_tuple("enums", module_scope.inner, exportedEnums);
         wrap_range_in_tuple("classes", module_scope.inner, exportedClasses);
+        exportNameTable(namespaceNames, enumNames, classNames, module_scope);
         // and another range to rule them all
         std::vector<std::string_view> all_decls;
         all_decls.insert(all_decls.end(), exportedNamespaces.begin(), exportedNamespaces.end());
@@ -200,9 +326,9 @@ namespace mc {
     }
 
     void ReflectionDataGenerator::exportType(const std::string &exportAs, clang::QualType type, descriptor_scope &where) {
-        const auto canonicalTypeName = type.getCanonicalType().getAsString(printingPolicy);
-        const auto plainTypeName = type.getAsString(printingPolicy);
-        const auto atomicTypeName = getUnitType(type).getCanonicalType().getAsString(printingPolicy);
+        const auto &canonicalTypeName = typeNames.canonicalName(type);
+        const auto &plainTypeName = typeNames.name(type);
+        const auto &atomicTypeName = typeNames.canonicalName(getUnitType(type));
         where.putline("static constexpr rosewood::Type<{0}> {3}{{\"{1}\", \"{0}\", \"{2}\"}};", canonicalTypeName, plainTypeName, atomicTypeName, exportAs);
     }
 
@@ -249,14 +375,14 @@ namespace mc {
         auto functionPrototype = method->getType()->getAs<clang::FunctionProtoType>();
         bool noExcept = isNoExcept(method);
 
-        sstream << method->getReturnType().getCanonicalType().getAsString(printingPolicy);
-        sstream << fmt::format(" ({}::*) (", clang::QualType(method->getParent()->getTypeForDecl(), 0).getAsString(printingPolicy));
+        sstream << typeNames.canonicalName(method->getReturnType());
+        sstream << fmt::format(" ({}::*) (", typeNames.name(clang::QualType(method->getParent()->getTypeForDecl(), 0)));
         if (method->parameters().empty()) {
 
         } else {
             int paramIdx = 0;
             for (const auto& parm: method->parameters()) {
-                sstream << parm->getType().getCanonicalType().getAsString(printingPolicy);
+                sstream << typeNames.canonicalName(parm->getType());
                 sstream << (paramIdx < (method->parameters().size() - 1) ? ",": "");
                 ++paramIdx;
             }
@@ -272,28 +398,49 @@ namespace mc {
     }
 
     void ReflectionDataGenerator::exportMethods(const clang::CXXRecordDecl *Record, const std::vector<const clang::CXXMethodDecl*> &methods, descriptor_scope &outerScope) {
+        llvm::TimeTraceScope timeScope("ExportMethods", [Record] { return Record->getQualifiedNameAsString(); });
 
         int methodIndex = 0;
 
-        outerScope.putline("static constexpr std::tuple methods {{");
-        ++outerScope.inner;
+        const bool outOfLine = isOutOfLine(methods.size());
+        std::string type;
+        if (outOfLine) {
+            const auto recordName = typeNames.name(clang::QualType(Record->getTypeForDecl(), 0));
+            for (const auto Method: methods) {
+                type += fmt::format("{}rosewood::MethodDeclaration<{}, {}, {}, {}", type.empty() ? "std::tuple<" : ", ", recordName,
+                                    typeNames.canonicalName(Method->getReturnType()), Method->getType()->getAs<clang::FunctionProtoType>()->isConst(), isNoExcept(Method));
+                for (const auto &param: Method->parameters()) {
+                    type += fmt::format(", {}", typeNames.canonicalName(param->getType()));
+                }
+                type += ">";
+            }
+            type += ">";
+        }
+
+        auto table = openTable(outerScope, "methods", "std::tuple", type, outOfLine);
         for(const auto Method: methods) {
             const bool isLast = methodIndex == (methods.size() - 1);
 
-            outerScope.putline("rosewood::MethodDeclaration {{");
-            ++outerScope.inner;
+            table.putline("rosewood::MethodDeclaration {{");
+            ++table;
+
+            const auto databaseMethod = database.addMember(databaseParent, rosewood::db::MemberKind::Method, Method->getNameAsString(), databaseType(Method->getReturnType()), 0,
+                                                           (Method->isConst() ? rosewood::db::Const : 0) | (isNoExcept(Method) ? rosewood::db::Noexcept : 0));
+            for (const auto &param: Method->parameters()) {
+                database.addParameter(databaseMethod, param->getNameAsString(), databaseType(param->getType()), param->hasDefaultArg() ? rosewood::db::HasDefaultArgument : 0);
+            }
 
-            outerScope.putline(fmt::format("static_cast<{}>(&{}),", buildMethodSignature(Method), Method->getQualifiedNameAsString()));
-            outerScope.putline(fmt::format("\"{}\",", Method->getNameAsString()));
+            table.putline(fmt::format("static_cast<{}>(&{}),", buildMethodSignature(Method), Method->getQualifiedNameAsString()));
+            table.putline(fmt::format("\"{}\",", Method->getNameAsString()));
             if (Method->parameters().empty()) {
-                outerScope.putline("std::tuple{{}}}}{}", isLast ? "" : ",");
+                table.putline("std::tuple{{}}}}{}", isLast ? "" : ",");
             } else {
                 int paramIdx = 0;
-                outerScope.putline("std::tuple{{");
-                ++outerScope.inner;
+                table.putline("std::tuple{{");
+                ++table;
                 for (const auto& param: Method->parameters()) {
-                    outerScope.putline(fmt::format("rosewood::FunctionParameter<{}>(\"{}\", {}, {}){}",
-                                                   param->getType().getCanonicalType().getAsString(printingPolicy),
+                    table.putline(fmt::format("rosewood::FunctionParameter<{}>(\"{}\", {}, {}){}",
+                                                   typeNames.canonicalName(param->getType()),
                                                    param->getNameAsString(),
                                                    param->hasDefaultArg(),
                                                    paramIdx,
@@ -301,49 +448,56 @@ namespace mc {
                                                    ));
                     ++paramIdx;
                 }
-                --outerScope.inner;
-                outerScope.putline("}}}}{}", isLast ? "" : ",");
+                --table;
+                table.putline("}}}}{}", isLast ? "" : ",");
             }
-            --outerScope.inner;
+            --table;
             ++methodIndex;
         }
-        --outerScope.inner;
-        outerScope.putline("}};");
+        closeTable(outerScope, outOfLine);
     }
 
     void ReflectionDataGenerator::exportConstructors(const std::vector<const clang::CXXConstructorDecl*> &ctors, const clang::CXXRecordDecl *record, descriptor_scope &outerScope) {
+        llvm::TimeTraceScope timeScope("ExportConstructors", [record] { return record->getQualifiedNameAsString(); });
         int methodIndex = 0;
 
-        outerScope.putline("static constexpr std::tuple constructors {{");
-        ++outerScope.inner;
-        for(const auto ctor: ctors) {
-            const bool isLast = methodIndex == (ctors.size() - 1);
-            const bool noExcept = isNoExcept(ctor);
-            outerScope.inner.put("rosewood::ConstructorDeclaration<{}, {}", clang::QualType(record->getTypeForDecl(), 0).getAsString(printingPolicy), noExcept);
-
-            if (ctor->parameters().empty()) {
-                outerScope.inner.rawput("> {{\n");
-            } else {
+        std::vector<std::string> declarationTypes;
+        declarationTypes.reserve(ctors.size());
+        for (const auto ctor: ctors) {
+            auto &declarationType = declarationTypes.emplace_back(fmt::format("rosewood::ConstructorDeclaration<{}, {}", typeNames.name(clang::QualType(record->getTypeForDecl(), 0)), isNoExcept(ctor)));
+            if (!ctor->parameters().empty()) {
                 int paramIdx = 0;
-                outerScope.inner.rawput(", ");
+                declarationType += ", ";
                 for (const auto& param: ctor->parameters()) {
-                    outerScope.inner.rawput("{}{}", param->getType().getCanonicalType().getAsString(printingPolicy), paramIdx < (ctor->parameters().size() - 1) ? ",": "");
+                    declarationType += fmt::format("{}{}", typeNames.canonicalName(param->getType()), paramIdx < (ctor->parameters().size() - 1) ? ",": "");
                     ++paramIdx;
                 }
-                outerScope.inner.rawput("> {{\n");
             }
+            declarationType += ">";
+        }
+
+        const bool outOfLine = isOutOfLine(ctors.size());
+        auto table = openTable(outerScope, "constructors", "std::tuple", outOfLine ? fmt::format("std::tuple<{}>", fmt::join(declarationTypes, ", ")) : std::string(), outOfLine);
+        for(const auto ctor: ctors) {
+            const bool isLast = methodIndex == (ctors.size() - 1);
+            const bool noExcept = isNoExcept(ctor);
+            const auto databaseConstructor = database.addMember(databaseParent, rosewood::db::MemberKind::Constructor, ctor->getNameAsString(), rosewood::db::none, 0, noExcept ? rosewood::db::Noexcept : 0);
+            for (const auto &param: ctor->parameters()) {
+                database.addParameter(databaseConstructor, param->getNameAsString(), databaseType(param->getType()), param->hasDefaultArg() ? rosewood::db::HasDefaultArgument : 0);
+            }
+            table.putline("{} {{", declarationTypes[methodIndex]);
 
-            ++outerScope.inner;
+            ++table;
 
             if (ctor->parameters().empty()) {
-                outerScope.putline("std::tuple{{}}}}{}", isLast ? "" : ",");
+                table.putline("std::tuple{{}}}}{}", isLast ? "" : ",");
             } else {
                 int paramIdx = 0;
-                outerScope.putline("std::tuple{{");
-                ++outerScope.inner;
+                table.putline("std::tuple{{");
+                ++table;
                 for (const auto& param: ctor->parameters()) {
-                    outerScope.putline(fmt::format("rosewood::FunctionParameter<{}>(\"{}\", {}, {}){}",
-                                                   param->getType().getCanonicalType().getAsString(printingPolicy),
+                    table.putline(fmt::format("rosewood::FunctionParameter<{}>(\"{}\", {}, {}){}",
+                                                   typeNames.canonicalName(param->getType()),
                                                    param->getNameAsString(),
                                                    param->hasDefaultArg(),
                                                    paramIdx,
@@ -351,35 +505,133 @@ namespace mc {
                                                    ));
                     ++paramIdx;
                 }
-                --outerScope.inner;
-                outerScope.putline("}}}}{}", isLast ? "" : ",");
+                --table;
+                table.putline("}}}}{}", isLast ? "" : ",");
             }
-            --outerScope.inner;
+            --table;
             ++methodIndex;
         }
-        --outerScope.inner;
-        outerScope.putline("}};");
+        closeTable(outerScope, outOfLine);
     }
 
     void ReflectionDataGenerator::exportFields(const std::vector<const clang::FieldDecl*> &fields, descriptor_scope &outerScope) {
-        outerScope.put("static constexpr std::tuple fields {{");
         if (fields.empty()) {
-            outerScope.inner.rawput("}};\n");
-        } else {
-            outerScope.inner.rawput("\n");
-            ++outerScope.inner;
-            int fIndex = 0;
-            const char* prefix = " ";
-            for(const auto& field: fields) {
-                outerScope.putline("{0} rosewood::FieldDeclaration<{1}, {2}>{{\"{3}\", &{2}::{3}, {4}, offsetof({2}, {3})}}",
-                                   std::exchange(prefix, ","),
-                                   field->getType().getCanonicalType().getAsString(printingPolicy),
-                                   clang::QualType(field->getParent()->getTypeForDecl(), 0).getAsString(printingPolicy),
-                                   field->getNameAsString(),
-                                   fIndex++);
+            outerScope.putline("static constexpr std::tuple fields {{}};");
+            return;
+        }
+
+        std::vector<std::string> declarationTypes;
+        declarationTypes.reserve(fields.size());
+        for (const auto& field: fields) {
+            declarationTypes.push_back(fmt::format("rosewood::FieldDeclaration<{}, {}>", typeNames.canonicalName(field->getType()), typeNames.name(clang::QualType(field->getParent()->getTypeForDecl(), 0))));
+        }
+
+        const bool outOfLine = isOutOfLine(fields.size());
+        auto table = openTable(outerScope, "fields", "std::tuple", outOfLine ? fmt::format("std::tuple<{}>", fmt::join(declarationTypes, ", ")) : std::string(), outOfLine);
+        int fIndex = 0;
+        const char* prefix = " ";
+        for(const auto& field: fields) {
+            const auto offset = context.toCharUnitsFromBits(context.getFieldOffset(field)).getQuantity();
+            database.addMember(databaseParent, rosewood::db::MemberKind::Field, field->getNameAsString(), databaseType(field->getType()), offset);
+            table.putline("{0} {1}{{\"{2}\", &{3}::{2}, {4}, offsetof({3}, {2})}}",
+                          std::exchange(prefix, ","),
+                          declarationTypes[fIndex],
+                          field->getNameAsString(),
+                          typeNames.name(clang::QualType(field->getParent()->getTypeForDecl(), 0)),
+                          fIndex);
+            ++fIndex;
+        }
+        closeTable(outerScope, outOfLine);
+    }
+
+    void ReflectionDataGenerator::exportMemberTable(const std::vector<std::tuple<std::string, std::string_view, std::size_t>> &members, descriptor_scope &where) {
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(members.size());
+        for (const auto &member: members) {
+            hashes.push_back(rosewood::hash_name(std::get<0>(member)));
+        }
+        // the members the table holds, by their index in the hashes it's built from
+        std::vector<std::size_t> tableMembers(members.size());
+        std::iota(tableMembers.begin(), tableMembers.end(), 0);
+        auto table = rosewood::PerfectHash::build(hashes);
+        auto &diagnostics = context.getDiagnostics();
+        if (!table) {
+            // only names that hash the same can't be told apart: the first of them keeps its place, the others are left out of the table
+            std::vector<std::uint64_t> distinctHashes;
+            std::set<std::uint64_t> seen;
+            tableMembers.clear();
+            for (std::size_t idx(0); idx < members.size(); ++idx) {
+                if (seen.insert(hashes[idx]).second) {
+                    tableMembers.push_back(idx);
+                    distinctHashes.push_back(hashes[idx]);
+                } else {
+                    diagnostics.Report(diagnostics.getCustomDiagID(clang::DiagnosticsEngine::Warning, "%0 in %1 hashes the same as another member, looking it up by name won't find it"))
+                        << std::get<0>(members[idx]) << where.qualifiedName;
+                }
+            }
+            table = rosewood::PerfectHash::build(distinctHashes);
+        }
+        if (!table) {
+            // the job fails along with the translation unit, rwc carries on with the others
+            diagnostics.Report(diagnostics.getCustomDiagID(clang::DiagnosticsEngine::Error, "no perfect hash separates the members of %0")) << where.qualifiedName;
+            return;
+        }
+
+        // constexpr even with out of line tables, it's small and StaticClass looks names up in it at compile time
+        where.putline("static constexpr rosewood::MemberTable<{}, {}> member_table {{", table->displacements.size(), table->slots.size());
+        auto inner = where.inner.spawn();
+        inner.putline("{{{{ {} }}}},", fmt::join(table->displacements, ", "));
+        inner.putline("{{{{");
+        ++inner;
+        for (std::size_t slot(0); slot < table->slots.size(); ++slot) {
+            const char *separator = slot + 1 < table->slots.size() ? "," : "";
+            if (table->slots[slot] == rosewood::PerfectHash::npos) {
+                inner.putline("rosewood::MemberSlot{{}}{}", separator);
+            } else {
+                const std::size_t member = tableMembers[table->slots[slot]];
+                const auto &[name, kind, index] = members[member];
+                inner.putline("rosewood::MemberSlot{{\"{}\", rosewood::MemberKind::{}, {}, {:#x}ull}}{}", name, kind, index, hashes[member], separator);
+            }
+        }
+        --inner;
+        inner.putline("}}}}");
+        where.putline("}};");
+    }
+
+    void ReflectionDataGenerator::exportNameTable(const std::vector<std::string> &namespaces, const std::vector<std::string> &enums, const std::vector<std::string> &classes, descriptor_scope &where) {
+        std::vector<std::tuple<std::string, std::string_view, std::size_t>> members;
+        std::set<std::string> memberNames;
+        for (const auto &[kind, names]: {std::pair("Namespace", &namespaces), std::pair("Enum", &enums), std::pair("Class", &classes)}) {
+            for (std::size_t idx(0); idx < names->size(); ++idx) {
+                if (!(*names)[idx].empty() && memberNames.insert((*names)[idx]).second) {
+                    members.emplace_back((*names)[idx], kind, idx);
+                }
             }
-            --outerScope.inner;
-            outerScope.inner.putline("}};");
+        }
+        exportMemberTable(members, where);
+    }
+
+    bool ReflectionDataGenerator::isOutOfLine(std::size_t tableSize) const {
+        // empty tables cost nothing, they stay in the header
+        return !job.sourceOutput.empty() && tableSize > 0;
+    }
+
+    scope ReflectionDataGenerator::openTable(descriptor_scope &where, std::string_view name, std::string_view inlineType, std::string_view type, bool outOfLine) {
+        if (!outOfLine) {
+            where.putline("static constexpr {} {} {{", inlineType, name);
+            return where.inner.spawn();
+        }
+        where.putline("static const {} {};", type, name);
+        source_scope.putline("");
+        source_scope.putline("decltype({0}::{1}) {0}::{1} {{", where.qualifiedName, name);
+        return source_scope.spawn();
+    }
+
+    void ReflectionDataGenerator::closeTable(descriptor_scope &where, bool outOfLine) {
+        if (outOfLine) {
+            source_scope.putline("}};");
+        } else {
+            where.putline("}};");
         }
     }
 
@@ -405,9 +657,12 @@ namespace mc {
 
 
     descriptor_scope ReflectionDataGenerator::exportCxxRecord(const std::string &name, const clang::CXXRecordDecl *Record, descriptor_scope &where) {
+        llvm::TimeTraceScope timeScope("ExportRecord", [Record] { return Record->getQualifiedNameAsString(); });
 
-        auto ownScope = where.spawn(name, "rosewood::StaticClass");
-        ownScope.putline("using type = {};", clang::QualType(Record->getTypeForDecl(), 0).getAsString(printingPolicy));
+        const auto outerDeclarationHeader = declarationHeader;
+        auto ownScope = spawnDescriptor(where, name, "rosewood::StaticClass");
+        const auto outerDatabaseParent = std::exchange(databaseParent, database.addDeclaration(databaseParent, rosewood::db::DeclarationKind::Class, name, databaseType(clang::QualType(Record->getTypeForDecl(), 0))));
+        ownScope.putline("using type = {};", typeNames.name(clang::QualType(Record->getTypeForDecl(), 0)));
         ownScope.putline("static constexpr std::string_view qualified_name = \"{}\";", Record->getQualifiedNameAsString());
         std::map<std::string_view, std::set<std::string>> descriptornames = {
             {"classes", {}},
@@ -485,11 +740,20 @@ namespace mc {
         auto prefix = "";
         for (const auto &base: Record->bases()) {
             if (base.getAccessSpecifier() == clang::AccessSpecifier::AS_public) {
-                ownScope.putline("{} {}", std::exchange(prefix, ","), base.getType().getCanonicalType().getAsString(printingPolicy));
+                ownScope.putline("{} {}", std::exchange(prefix, ","), typeNames.canonicalName(base.getType()));
             }
         }
         ownScope.putline(">;");
 
+        // overloads follow each other, in the order the first of them is declared in, so that the member table and the runtime models find all of them from the first
+        std::map<std::string, std::size_t> firstOverloads;
+        for (std::size_t idx(0); idx < exportedMethods.size(); ++idx) {
+            firstOverloads.emplace(exportedMethods[idx]->getNameAsString(), idx);
+        }
+        std::stable_sort(exportedMethods.begin(), exportedMethods.end(), [&firstOverloads] (const clang::CXXMethodDecl *lhs, const clang::CXXMethodDecl *rhs) {
+            return firstOverloads[lhs->getNameAsString()] < firstOverloads[rhs->getNameAsString()];
+        });
+
         exportConstructors(constructors, Record, ownScope);
         exportMethods(Record, exportedMethods, ownScope);
         exportFields(fields, ownScope);
@@ -498,15 +762,39 @@ namespace mc {
             // exportCxxDestructor(destructor, Record, ownScope);
         }
 
+        std::vector<std::pair<std::string, std::string>> classDescriptors;
         for(const auto cls: classes) {
-            auto exportedScope = exportCxxRecord(cls->getNameAsString(), cls, ownScope);
-            descriptornames["classes"].emplace(fmt::format("meta_{}", exportedScope.name));
+            const auto &descriptor = classDescriptors.emplace_back(cls->getNameAsString(), recordDescriptor(cls->getNameAsString(), cls, ownScope)).second;
+            descriptornames["classes"].emplace(descriptor);
         }
+        std::vector<std::pair<std::string, std::string>> enumDescriptors;
         for(const auto en: enums) {
-            auto exportedScope = exportEnum(en, ownScope);
-            descriptornames["enums"].emplace(fmt::format("meta_{}", exportedScope.name));
+            const auto &descriptor = enumDescriptors.emplace_back(enumName(en), enumDescriptor(en, ownScope)).second;
+            descriptornames["enums"].emplace(descriptor);
         }
 
+        // where every member ends up in the tables and tuples of the descriptor. Members hide nested types of the same name
+        std::vector<std::tuple<std::string, std::string_view, std::size_t>> members;
+        std::set<std::string> memberNames;
+        auto addMember = [&members, &memberNames] (const std::string &memberName, std::string_view kind, std::size_t index) {
+            if (!memberName.empty() && memberNames.insert(memberName).second) {
+                members.emplace_back(memberName, kind, index);
+            }
+        };
+        for (std::size_t idx(0); idx < exportedMethods.size(); ++idx) {
+            addMember(exportedMethods[idx]->getNameAsString(), "Method", idx);
+        }
+        for (std::size_t idx(0); idx < fields.size(); ++idx) {
+            addMember(fields[idx]->getNameAsString(), "Field", idx);
+        }
+        for (const auto &[rangeName, kind, descriptors]: {std::tuple("enums", "Enum", &enumDescriptors), std::tuple("classes", "Class", &classDescriptors)}) {
+            const auto &range = descriptornames[rangeName];
+            for (const auto &[declName, descriptor]: *descriptors) {
+                addMember(declName, kind, std::distance(range.begin(), range.find(descriptor)));
+            }
+        }
+        exportMemberTable(members, ownScope);
+
         std::vector<std::string_view> all_decls;
         for(const auto& [rangeName, range]: descriptornames) {
             wrap_range_in_tuple(rangeName, ownScope.inner, range);
@@ -515,59 +803,190 @@ namespace mc {
         }
         wrap_range_in_tuple("declarations", ownScope.inner, all_decls);
 
-        exportedMetaTypes.emplace_back(std::tuple(clang::QualType(Record->getTypeForDecl(),0).getAsString(printingPolicy), ownScope.qualifiedName));
+        addMetaType(typeNames.name(clang::QualType(Record->getTypeForDecl(),0)), ownScope.qualifiedName);
+        idrepo.defineIdentifier(typeNames.name(clang::QualType(Record->getTypeForDecl(),0)), ownScope.qualifiedName, definingHeader());
+        databaseParent = outerDatabaseParent;
+        declarationHeader = outerDeclarationHeader;
         return ownScope;
     }
 
-    descriptor_scope ReflectionDataGenerator::exportEnum(const clang::EnumDecl *Enum, descriptor_scope &where) {
-        auto qualName = Enum->getQualifiedNameAsString();
-        auto name = Enum->getNameAsString();
-        if (name.empty()) {
-            name = Enum->getTypedefNameForAnonDecl()->getNameAsString();
-            qualName = Enum->getTypedefNameForAnonDecl()->getQualifiedNameAsString();
+
+    const IdentifierInfo *ReflectionDataGenerator::findExported(const std::string &identifier) {
+        if (auto own = idrepo.find(identifier)) {
+            if (declarationHeader && own->header != declarationHeader->path) {
+                declarationHeader->includes.insert(own->header);
+            }
+            return own;
+        }
+        if (!imports) {
+            return nullptr;
+        }
+        auto imported = imports->find(identifier);
+        if (imported) {
+            idrepo.expectExternalIdentifier(identifier);
+            importedHeaders.insert(imported->header);
+        }
+        return imported;
+    }
+
+    descriptor_scope ReflectionDataGenerator::spawnDescriptor(descriptor_scope &where, const std::string &name, const std::string &kind) {
+        // declarations nested in a class are part of the header of the class
+        if (job.declarationDirectory.empty() || declarationHeader) {
+            return where.spawn(name, kind);
+        }
+
+        // rosewood::meta_Module::meta_basic::meta_Enum is defined by basic.Enum.h
+        std::string fileName = fmt::format("{}::meta_{}", where.qualifiedName, name).substr(fmt::format("rosewood::meta_{}::meta_", job.moduleName).size());
+        for (std::size_t separator; (separator = fileName.find("::meta_")) != std::string::npos;) {
+            fileName.replace(separator, std::string_view("::meta_").size(), ".");
+        }
+
+        declarationHeader = &declarationHeaders.emplace_back();
+        declarationHeader->path = fmt::format("{}/{}.h", job.declarationDirectory, fileName);
+        return where.spawnOutOfLine(scope(declarationHeader->out, 1), name, kind);
+    }
+
+    void ReflectionDataGenerator::addMetaType(const std::string &declName, const std::string &descriptorName) {
+        (declarationHeader ? declarationHeader->metaTypes : exportedMetaTypes).emplace_back(declName, descriptorName);
+    }
+
+    const std::string &ReflectionDataGenerator::definingHeader() const {
+        return declarationHeader ? declarationHeader->path : job.output;
+    }
+
+    std::string ReflectionDataGenerator::recordDescriptor(const std::string &name, const clang::CXXRecordDecl *Record, descriptor_scope &where) {
+        if (auto exported = findExported(typeNames.name(clang::QualType(Record->getTypeForDecl(), 0)))) {
+            return exported->name;
         }
+        return fmt::format("meta_{}", exportCxxRecord(name, Record, where).name);
+    }
+
+    std::string ReflectionDataGenerator::enumDescriptor(const clang::EnumDecl *Enum, descriptor_scope &where) {
+        if (auto exported = findExported(enumQualifiedName(Enum))) {
+            return exported->name;
+        }
+        return fmt::format("meta_{}", exportEnum(Enum, where).name);
+    }
 
-        auto ownScope = where.spawn(name, "rosewood::Enum");
+    descriptor_scope ReflectionDataGenerator::exportEnum(const clang::EnumDecl *Enum, descriptor_scope &where) {
+        llvm::TimeTraceScope timeScope("ExportEnum", [Enum] { return Enum->getQualifiedNameAsString(); });
+        auto qualName = enumQualifiedName(Enum);
+        auto name = enumName(Enum);
+
+        const auto outerDeclarationHeader = declarationHeader;
+        auto ownScope = spawnDescriptor(where, name, "rosewood::Enum");
+        const auto databaseEnum = database.addDeclaration(databaseParent, rosewood::db::DeclarationKind::Enum, name, databaseType(Enum->getIntegerType()));
         ownScope.putline("using type = {};", qualName);
-        ownScope.putline("using enumerator_type = Enumerator<{}>;", Enum->getIntegerType().getAsString(printingPolicy));
+        ownScope.putline("using enumerator_type = Enumerator<{}>;", typeNames.name(Enum->getIntegerType()));
         std::vector<clang::EnumConstantDecl*> enumerators(Enum->enumerators().begin(), Enum->enumerators().end());
-        ownScope.putline("static constexpr std::array<Enumerator<{}>, {}> enumerators {{", Enum->getIntegerType().getAsString(printingPolicy), enumerators.size());
+        const auto arrayType = fmt::format("std::array<Enumerator<{}>, {}>", typeNames.name(Enum->getIntegerType()), enumerators.size());
+        const bool outOfLine = isOutOfLine(enumerators.size());
+        auto enScope = openTable(ownScope, "enumerators", arrayType, arrayType, outOfLine);
 
         for(unsigned index(0); index < enumerators.size(); ++index) {
             auto enumerator = enumerators[index];
             auto enName = enumerator->getNameAsString();
-            auto enScope = ownScope.inner.spawn();
-            enScope.putline("Enumerator<{}> {{ {}, \"{}\" }}{}", Enum->getIntegerType().getAsString(printingPolicy), enumerator->getInitVal().toString(10), enName, index < (enumerators.size() - 1) ? ",": std::string());
+            database.addMember(databaseEnum, rosewood::db::MemberKind::Enumerator, enName, rosewood::db::none, enumerator->getInitVal().getExtValue());
+            enScope.putline("Enumerator<{}> {{ {}, \"{}\" }}{}", typeNames.name(Enum->getIntegerType()), enumerator->getInitVal().toString(10), enName, index < (enumerators.size() - 1) ? ",": std::string());
         }
 
-        ownScope.putline("}};");
-        exportedMetaTypes.emplace_back(std::tuple(qualName, ownScope.qualifiedName));
+        closeTable(ownScope, outOfLine);
+        exportEnumLookups(Enum, enumerators, ownScope);
+        addMetaType(qualName, ownScope.qualifiedName);
+        idrepo.defineIdentifier(qualName, ownScope.qualifiedName, definingHeader());
+        declarationHeader = outerDeclarationHeader;
         return ownScope;
     }
 
+    void ReflectionDataGenerator::exportEnumLookups(const clang::EnumDecl *Enum, const std::vector<clang::EnumConstantDecl*> &enumerators, descriptor_scope &where) {
+        auto putIndexTable = [this, &where] (std::string_view name, const std::vector<std::string> &indices) {
+            const auto arrayType = fmt::format("std::array<std::uint32_t, {}>", indices.size());
+            const bool outOfLine = isOutOfLine(indices.size());
+            auto table = openTable(where, name, arrayType, arrayType, outOfLine);
+            // a few indices per line, these tables get as long as the enum
+            for (std::size_t first(0); first < indices.size(); first += 16) {
+                const auto last = std::min(first + 16, indices.size());
+                table.putline("{}{}", fmt::join(indices.begin() + first, indices.begin() + last, ", "), last < indices.size() ? "," : "");
+            }
+            closeTable(where, outOfLine);
+        };
+
+        std::vector<std::uint32_t> byName(enumerators.size());
+        std::iota(byName.begin(), byName.end(), 0u);
+        std::sort(byName.begin(), byName.end(), [&enumerators] (std::uint32_t lhs, std::uint32_t rhs) {
+            return enumerators[lhs]->getName() < enumerators[rhs]->getName();
+        });
+
+        // aliases are left out, a value stands for the first enumerator declared with it
+        std::vector<std::uint32_t> byValue(enumerators.size());
+        std::iota(byValue.begin(), byValue.end(), 0u);
+        std::stable_sort(byValue.begin(), byValue.end(), [&enumerators] (std::uint32_t lhs, std::uint32_t rhs) {
+            return llvm::APSInt::compareValues(enumerators[lhs]->getInitVal(), enumerators[rhs]->getInitVal()) < 0;
+        });
+        byValue.erase(std::unique(byValue.begin(), byValue.end(), [&enumerators] (std::uint32_t lhs, std::uint32_t rhs) {
+            return llvm::APSInt::compareValues(enumerators[lhs]->getInitVal(), enumerators[rhs]->getInitVal()) == 0;
+        }), byValue.end());
+
+        // values spanning up to twice as many slots as there are enumerators, or a handful of them, get a table indexed by value
+        auto distanceFromLowest = [&enumerators, &byValue] (std::uint32_t index) {
+            const auto &lowest = enumerators[byValue.front()]->getInitVal();
+            const auto &value = enumerators[index]->getInitVal();
+            const unsigned width = std::max(lowest.getBitWidth(), value.getBitWidth()) + 1;
+            return (value.extend(width) - lowest.extend(width)).getLimitedValue();
+        };
+        const std::uint64_t slots = std::max<std::uint64_t>(2 * byValue.size(), 64);
+        const bool dense = byValue.empty() || distanceFromLowest(byValue.back()) < slots;
+
+        where.putline("static constexpr bool dense_values = {};", dense);
+        where.putline("static constexpr {} lowest_value = {};", typeNames.name(Enum->getIntegerType()), byValue.empty() ? "0" : enumerators[byValue.front()]->getInitVal().toString(10));
+
+        std::vector<std::string> valueIndices;
+        if (dense && !byValue.empty()) {
+            valueIndices.assign(distanceFromLowest(byValue.back()) + 1, "no_enumerator");
+            for (const auto index: byValue) {
+                valueIndices[distanceFromLowest(index)] = std::to_string(index);
+            }
+        } else if (!dense) {
+            std::transform(byValue.begin(), byValue.end(), std::back_inserter(valueIndices), [] (std::uint32_t index) { return std::to_string(index); });
+        }
+        putIndexTable("by_value", valueIndices);
+
+        std::vector<std::string> nameIndices;
+        std::transform(byName.begin(), byName.end(), std::back_inserter(nameIndices), [] (std::uint32_t index) { return std::to_string(index); });
+        putIndexTable("by_name", nameIndices);
+    }
+
     descriptor_scope ReflectionDataGenerator::exportNamespace(const clang::NamespaceDecl *Namespace, descriptor_scope &where) {
+        llvm::TimeTraceScope timeScope("ExportNamespace", [Namespace] { return Namespace->getQualifiedNameAsString(); });
         auto qualName = Namespace->getQualifiedNameAsString();
         auto name = Namespace->getNameAsString();
         auto ownScope = where.spawn(name, "rosewood::Namespace");
+        const auto outerDatabaseParent = std::exchange(databaseParent, database.addDeclaration(databaseParent, rosewood::db::DeclarationKind::Namespace, name));
 
         ownScope.print_header();
 
         std::vector<std::string> exportedNamespaces;
         std::vector<std::string> exportedEnums;
         std::vector<std::string> exportedClasses;
+        std::vector<std::string> namespaceNames;
+        std::vector<std::string> enumNames;
+        std::vector<std::string> classNames;
 
         for(const auto decl: Namespace->decls()) {
             switch(auto declKind = decl->getKind()) {
-            case clang::Decl::Kind::Namespace:
-                exportedNamespaces.push_back(fmt::format("meta_{}", exportNamespace(static_cast<const clang::NamespaceDecl*>(decl), ownScope).name));
-                break;
+            case clang::Decl::Kind::Namespace: {
+                const auto &nestedName = namespaceNames.emplace_back(exportNamespace(static_cast<const clang::NamespaceDecl*>(decl), ownScope).name);
+                exportedNamespaces.push_back(fmt::format("meta_{}", nestedName));
+            } break;
             case clang::Decl::Kind::Enum:
-                exportedEnums.push_back(fmt::format("meta_{}", exportEnum(static_cast<const clang::EnumDecl*>(decl), ownScope).name));
+                exportedEnums.push_back(enumDescriptor(static_cast<const clang::EnumDecl*>(decl), ownScope));
+                enumNames.push_back(enumName(static_cast<const clang::EnumDecl*>(decl)));
                 break;
             case clang::Decl::Kind::CXXRecord: {
                 auto record = static_cast<const clang::CXXRecordDecl*>(decl);
                 if (record->isThisDeclarationADefinition()) {
-                    exportedClasses.push_back(fmt::format("meta_{}", exportCxxRecord(record->getNameAsString()  , record, ownScope).name));
+                    exportedClasses.push_back(recordDescriptor(record->getNameAsString(), record, ownScope));
+                    classNames.push_back(record->getNameAsString());
                 }
             } break;
             case clang::Decl::TypeAlias: {
@@ -577,8 +996,13 @@ namespace mc {
                     auto record = aliasedType->getAsCXXRecordDecl();
                     if (record->getKind() == clang::Decl::Kind::ClassTemplateSpecialization) {
                         auto specialization = static_cast<clang::ClassTemplateSpecializationDecl*>(record);
-                        sema.RequireCompleteType(alias->getLocation(), clang::QualType(specialization->getTypeForDecl(), 0), 1);
-                        exportedClasses.push_back(fmt::format("meta_{}", exportCxxRecord(alias->getNameAsString(), specialization->getDefinition(), ownScope).name));
+                        {
+                            llvm::TimeTraceScope timeScope("RequireCompleteType", [alias] { return alias->getQualifiedNameAsString(); });
+                            sema.RequireCompleteType(alias->getLocation(), clang::QualType(specialization->getTypeForDecl(), 0), 1);
+                        }
+                        // several aliases, of this module or of others, often name the same specialization
+                        exportedClasses.push_back(recordDescriptor(alias->getNameAsString(), specialization->getDefinition(), ownScope));
+                        classNames.push_back(alias->getNameAsString());
                     }
                 }
             };
@@ -589,6 +1013,7 @@ namespace mc {
         wrap_range_in_tuple("namespaces", ownScope.inner, exportedNamespaces);
         wrap_range_in_tuple("enums", ownScope.inner, exportedEnums);
         wrap_range_in_tuple("classes", ownScope.inner, exportedClasses);
+        exportNameTable(namespaceNames, enumNames, classNames, ownScope);
 
 
         std::vector<std::string_view> all_decls;
@@ -598,6 +1023,7 @@ namespace mc {
 
         wrap_range_in_tuple("declarations", ownScope.inner, all_decls);
 
+        databaseParent = outerDatabaseParent;
         return ownScope;
     }
 
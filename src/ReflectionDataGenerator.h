@@ -2,6 +2,9 @@
 
 #include "IdentifierHelper.h"
 #include "IdentifierRepository.h"
+#include "ReflectionJob.h"
+#include "GeneratedFiles.h"
+#include "DatabaseWriter.h"
 
 #pragma warning(push, 0)
 #include <clang/AST/AST.h>
@@ -9,8 +12,14 @@
 #include <clang/Sema/Sema.h>
 #pragma warning(pop)
 
-#include <fstream>
+#include <rosewood/perfect_hash.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <set>
 #include <vector>
+#include <fmt/format.h>
 #include <fmt/ostream.h>
 
 inline std::ostream& operator<< (std::ostream& os, const llvm::StringRef& v) {
@@ -20,30 +29,31 @@ inline std::ostream& operator<< (std::ostream& os, const llvm::StringRef& v) {
     return os;
 }
 
-extern llvm::cl::opt<std::string> mcModuleName;
-
 namespace mc {
 
+/**
+ * @brief The scope struct appends indented text to an in-memory buffer. Nothing reaches the disk before the whole file is generated.
+ */
 struct scope {
     scope(const scope &other) = default;
 
-    scope(std::ostream &Out, int Indentation)
+    scope(fmt::memory_buffer &Out, int Indentation)
         :out(Out),
           indentation(Indentation) {}
 
     void indent() {
-        int ind(indentation);
-        if (ind > 0) {
-            while (ind > 0) {
-                out << ' ' << ' ';
-                --ind;
-            }
+        // two spaces per level, copied over from a fixed run of spaces rather than one at a time
+        static constexpr std::string_view spaces = "                                                                ";
+        for (std::size_t remaining = 2 * static_cast<std::size_t>(std::max(indentation, 0)); remaining > 0;) {
+            const std::size_t chunk = std::min(remaining, spaces.size());
+            out.append(spaces.data(), spaces.data() + chunk);
+            remaining -= chunk;
         }
     }
 
     template<typename ...Args>
     void rawput(std::string_view format, Args &&...args) {
-        fmt::print(out, format, std::forward<Args&&>(args)...);
+        fmt::vformat_to(std::back_inserter(out), format, fmt::make_format_args(args...));
     }
 
     template<typename ...Args>
@@ -55,7 +65,7 @@ struct scope {
     template<typename ...Args>
     void putline(std::string_view format, Args &&...args) {
         put(format, std::forward<Args&&>(args)...);
-        fmt::print(out, "\n");
+        out.push_back('\n');
     }
 
     scope spawn() {
@@ -74,19 +84,20 @@ struct scope {
 
 
 private:
-    std::ostream &out;
+    fmt::memory_buffer &out;
 protected:
     int indentation;
 };
 
 struct descriptor_scope {
 
-    descriptor_scope(scope Outer, const std::string &Name, const std::string &Kind, const std::string &parentQualName = "")
+    descriptor_scope(scope Outer, const std::string &Name, const std::string &Kind, const std::string &parentQualName = "", bool OutOfLine = false)
         :outer(Outer),
          inner(outer.spawn()),
          name(Name),
          kind(Kind),
-         qualifiedName(fmt::format("{}::meta_{}", parentQualName.empty() ? "rosewood" : parentQualName, Name)) {}
+         qualifiedName(fmt::format("{}::meta_{}", parentQualName.empty() ? "rosewood" : parentQualName, Name)),
+         outOfLine(OutOfLine) {}
 
     descriptor_scope(const descriptor_scope &other) = delete;
     descriptor_scope(descriptor_scope &&other)
@@ -94,7 +105,8 @@ struct descriptor_scope {
         inner(other.inner),
         name(std::move(other.name)),
         kind(std::move(other.kind)),
-        qualifiedName(std::move(other.kind)),
+        qualifiedName(std::move(other.qualifiedName)),
+        outOfLine(other.outOfLine),
         printed_header(other.printed_header) {
         other.moved = true;
     }
@@ -111,6 +123,14 @@ struct descriptor_scope {
         return descriptor_scope(inner, Name, Kind, qualifiedName);
     }
 
+    /**
+     * @brief spawnOutOfLine only declares the nested descriptor Name, which is defined in Outer, at namespace scope, by its qualified name
+     */
+    descriptor_scope spawnOutOfLine(scope Outer, const std::string& Name, const std::string &Kind) {
+        putline("struct meta_{};", Name);
+        return descriptor_scope(Outer, Name, Kind, qualifiedName, true);
+    }
+
     template<typename ...Args>
     void put(std::string_view format, Args &&...args) {
         print_header();
@@ -126,8 +146,15 @@ struct descriptor_scope {
     void print_header() {
         if (!printed_header && !name.empty()) {
             outer.putline("");
-            outer.putline("struct meta_{} : public {}<meta_{}> {{", name, kind, name);
+            if (outOfLine) {
+                // relative to the rosewood namespace the definition is in
+                const std::string_view definedName = std::string_view(qualifiedName).substr(std::string_view("rosewood::").size());
+                outer.putline("struct {0} : public {1}<{0}> {{", definedName, kind);
+            } else {
+                outer.putline("struct meta_{} : public {}<meta_{}> {{", name, kind, name);
+            }
             inner.putline("static constexpr std::string_view name = \"{}\";", name);
+            inner.putline("static constexpr std::uint64_t name_hash = {:#x}ull;", rosewood::hash_name(name));
             printed_header = true;
         }
     }
@@ -143,6 +170,7 @@ struct descriptor_scope {
     const std::string name;
     const std::string kind;
     const std::string qualifiedName; // holds a path that leads to this descriptor from the global namespace
+    const bool outOfLine = false; // defined outside of its parent, see spawnOutOfLine
 private:
     bool moved = false;
     bool printed_header = false;
@@ -152,41 +180,122 @@ private:
     class ReflectionDataGenerator {
 
     public:
-        explicit ReflectionDataGenerator(clang::ASTContext &astContext, clang::Sema &sema);
+        /**
+         * @param file the file holding the declarations to reflect on, job.source as the compiler found it
+         * @param imports if not null, the descriptors of other modules. They are referred to rather than generated again
+         * @param typeNames the cache of the translation unit, shared by the generators of all of its jobs
+         */
+        ReflectionDataGenerator(clang::ASTContext &astContext, clang::Sema &sema, const ReflectionJob &job, const clang::FileEntry *file, const IdentifierRepository *imports, GeneratedFiles &outputs, JobStatistics &statistics, TypeNameCache &typeNames);
         ~ReflectionDataGenerator();
 
         void Generate();
 
     private:
         clang::QualType getUnitType(clang::QualType T);
+        bool isInReflectedFile(clang::SourceLocation location) const;
+        DatabaseWriter::Index databaseType(clang::QualType type);
         void exportType(const std::string &exportAs, clang::QualType type, descriptor_scope &where);
         descriptor_scope exportDeclaration(const clang::Decl *Decl, descriptor_scope &where);
 
         descriptor_scope exportNamespace(const clang::NamespaceDecl *Namespace, descriptor_scope &where);
         descriptor_scope exportEnum(const clang::EnumDecl *Enum, descriptor_scope &where);
+        /**
+         * @brief exportEnumLookups adds the tables rosewood::Enum looks enumerators up by value and by name with, see rosewood.hpp
+         */
+        void exportEnumLookups(const clang::EnumDecl *Enum, const std::vector<clang::EnumConstantDecl*> &enumerators, descriptor_scope &where);
         descriptor_scope exportCxxRecord(const std::string &name, const clang::CXXRecordDecl *Record, descriptor_scope &where);
 
+        /**
+         * @return the descriptor of Record, exported into where unless this module or one it imports did already
+         */
+        std::string recordDescriptor(const std::string &name, const clang::CXXRecordDecl *Record, descriptor_scope &where);
+        std::string enumDescriptor(const clang::EnumDecl *Enum, descriptor_scope &where);
+        const IdentifierInfo *findExported(const std::string &identifier);
+
+        /**
+         * @brief spawnDescriptor spawns the descriptor of a class or enum declared in where. With job.declarationDirectory, those declared
+         * in a namespace get a header of their own, which becomes the current declarationHeader. where then only declares them
+         */
+        descriptor_scope spawnDescriptor(descriptor_scope &where, const std::string &name, const std::string &kind);
+        void addMetaType(const std::string &declName, const std::string &descriptorName);
+        const std::string &definingHeader() const;
+
+        /**
+         * @brief addModuleInterface adds the module interface unit of job.moduleInterfaceOutput. It exports the descriptors of out up to descriptorsEnd,
+         * followed by those of the declaration headers and all of the meta specializations
+         */
+        void addModuleInterface(std::size_t descriptorsEnd);
+
         bool areMethodArgumentsPubliclyUsable(const clang::CXXMethodDecl* method);
 
         void exportMethods(const clang::CXXRecordDecl *Record, const std::vector<const clang::CXXMethodDecl*> &overloads, descriptor_scope &outerScope);
         descriptor_scope exportFunctions(const std::string &name, const std::vector<const clang::FunctionDecl*> &overloads, descriptor_scope &where);
         void exportConstructors(const std::vector<const clang::CXXConstructorDecl*> &overloads, const clang::CXXRecordDecl *record, descriptor_scope &where);
         void exportFields(const std::vector<const clang::FieldDecl*> &fields, descriptor_scope &where);
+        /**
+         * @brief exportMemberTable adds the rosewood::MemberTable of a class
+         * @param members the name, rosewood::MemberKind and index of every member, in the order the runtime model prefers them in
+         */
+        void exportMemberTable(const std::vector<std::tuple<std::string, std::string_view, std::size_t>> &members, descriptor_scope &where);
+        /**
+         * @brief exportNameTable adds the rosewood::MemberTable of a namespace or module, over the names of its namespaces, enums and classes
+         */
+        void exportNameTable(const std::vector<std::string> &namespaces, const std::vector<std::string> &enums, const std::vector<std::string> &classes, descriptor_scope &where);
+
+        /**
+         * @brief openTable starts the static table name of the descriptor of where, whose elements are put into the returned scope until closeTable.
+         * Tables are constexpr members of the header, unless outOfLine. The header then only declares them, with their type spelled out, and job.sourceOutput defines them
+         */
+        scope openTable(descriptor_scope &where, std::string_view name, std::string_view inlineType, std::string_view type, bool outOfLine);
+        void closeTable(descriptor_scope &where, bool outOfLine);
+        bool isOutOfLine(std::size_t tableSize) const;
 
         void genMethodCallUnpacker(const clang::CXXMethodDecl *method);
         std::string buildMethodSignature(const clang::CXXMethodDecl *method);
 
-        std::ofstream out;
+        const ReflectionJob &job;
+        const clang::FileEntry *file;
+        const IdentifierRepository *imports;
+        GeneratedFiles &outputs; // nothing is written to disk before the whole job succeeded
+        JobStatistics &statistics;
+        fmt::memory_buffer out;
+        // the definitions of the out of line tables, see openTable
+        fmt::memory_buffer sourceOut;
         mc::IdentifierHelper idman;
         mc::IdentifierRepository idrepo;
+        // the headers of the imported descriptors referred to, included right after the reflected file
+        std::set<std::string> importedHeaders;
+        std::size_t importedHeadersPosition = 0;
+        // where the includes of the header start and where its descriptors do, see addModuleInterface
+        std::size_t preamblePosition = 0;
+        std::size_t bodyPosition = 0;
 
         scope global_scope = scope(out, 0);
+        scope source_scope = scope(sourceOut, 1);
 
         std::vector<std::tuple<std::string, std::string>> exportedMetaTypes; // all enums and classes get one of these. more to come
 
+        struct DeclarationHeader {
+            std::string path;
+            fmt::memory_buffer out;
+            std::vector<std::tuple<std::string, std::string>> metaTypes;
+            // the other declaration headers defining descriptors this one refers to
+            std::set<std::string> includes;
+        };
+        // one per class and enum declared in a namespace with job.declarationDirectory, a list so the scopes writing to them stay valid
+        std::list<DeclarationHeader> declarationHeaders;
+        DeclarationHeader *declarationHeader = nullptr;
+
         clang::ASTContext &context;
         clang::Sema &sema;
-        clang::PrintingPolicy printingPolicy;
+        TypeNameCache &typeNames;
+        // where the counts of the cache were when this job started, the statistics of the job are the difference
+        const std::size_t typeNameLookupsBefore;
+        const std::size_t typeNameHitsBefore;
+
+        DatabaseWriter database;
+        // where exported declarations go in the database, follows the nesting of the export functions
+        DatabaseWriter::Index databaseParent = DatabaseWriter::root;
     };
 
 
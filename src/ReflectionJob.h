@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mc {
+
+    /**
+     * @brief FrontendProfile selects how much work the compiler does while parsing a source.
+     */
+    enum class FrontendProfile {
+        // a regular compilation up to and including semantic analysis
+        Full,
+        // skips what the generated data doesn't depend on: function bodies, warnings and spell checking. See applyFrontendProfile
+        Fast
+    };
+
+    /**
+     * @brief JobStatistics counts some of the work done for the jobs of a translation unit, reported by rwc -stats.
+     */
+    struct JobStatistics {
+        struct TypeNames {
+            std::string source;
+            std::size_t lookups = 0;
+            // lookups that didn't need to print the type again, see TypeNameCache
+            std::size_t hits = 0;
+        };
+
+        // one per job, in the order they were generated in. The jobs of a unit share its TypeNameCache, so later ones hit more
+        std::vector<TypeNames> jobs;
+        // those of every job of the unit
+        std::size_t typeNameLookups = 0;
+        std::size_t typeNameHits = 0;
+    };
+
+    /**
+     * @brief ReflectionJob describes the work needed to reflect on a single header: where it's read from and where the generated data goes.
+     */
+    struct ReflectionJob {
+        std::string source;
+        std::string moduleName;
+        std::string output;
+        std::string databaseOutput;
+        // optional, a Make style depfile listing every file read while parsing source
+        std::string depfile;
+        // optional, where to save the IdentifierRepository of the module for the modules depending on it
+        std::string repositoryOutput;
+        // optional, the source defining the method, constructor, field and enumerator tables. output then only declares them
+        std::string sourceOutput;
+        // optional, the directory receiving a header per class and enum declared in a namespace. output then only includes them
+        std::string declarationDirectory;
+        // optional, where to write the generated data as the C++20 module interface unit of module `<moduleName>.meta`
+        std::string moduleInterfaceOutput;
+
+        /**
+         * @brief fingerprint covers every part of the job that makes a difference to its outputs, other than the contents of the source.
+         */
+        std::string fingerprint() const {
+            return source + '\n' + moduleName + '\n' + output + '\n' + databaseOutput + '\n' + depfile + '\n' + repositoryOutput + '\n' + sourceOutput + '\n' + declarationDirectory + '\n' + moduleInterfaceOutput;
+        }
+    };
+
+}
@@ -0,0 +1,197 @@
+#include "Server.h"
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#pragma warning(push, 0)
+#include <llvm/Support/FileSystem.h>
+#pragma warning(pop)
+
+namespace mc {
+
+#ifndef _WIN32
+    namespace {
+        // The protocol is as simple as it gets since both ends are the same binary on the same machine.
+        // A request is a list of strings: the working directory of the client followed by its command line.
+        // The response is the exit code followed by the diagnostics of the request.
+        // Strings are sent as their size followed by their characters and lists as their size followed by their strings.
+
+        bool writeAll(int fd, const void *data, std::size_t size) {
+            auto bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                const auto written = ::write(fd, bytes, size);
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                bytes += written;
+                size -= static_cast<std::size_t>(written);
+            }
+            return true;
+        }
+
+        bool readAll(int fd, void *data, std::size_t size) {
+            auto bytes = static_cast<char*>(data);
+            while (size > 0) {
+                const auto got = ::read(fd, bytes, size);
+                if (got < 0 && errno == EINTR) continue;
+                if (got <= 0) return false;
+                bytes += got;
+                size -= static_cast<std::size_t>(got);
+            }
+            return true;
+        }
+
+        bool writeNumber(int fd, std::uint32_t number) {
+            return writeAll(fd, &number, sizeof(number));
+        }
+
+        bool readNumber(int fd, std::uint32_t &number) {
+            return readAll(fd, &number, sizeof(number));
+        }
+
+        bool writeString(int fd, const std::string &str) {
+            return writeNumber(fd, static_cast<std::uint32_t>(str.size())) && writeAll(fd, str.data(), str.size());
+        }
+
+        bool readString(int fd, std::string &str) {
+            std::uint32_t size;
+            if (!readNumber(fd, size)) return false;
+            str.resize(size);
+            return readAll(fd, str.data(), size);
+        }
+
+        bool makeAddress(const std::string &socketPath, sockaddr_un &address) {
+            address = {};
+            address.sun_family = AF_UNIX;
+            if (socketPath.size() >= sizeof(address.sun_path)) {
+                return false;
+            }
+            std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+            return true;
+        }
+
+        void serveConnection(int connection, const RequestHandler &handler) {
+            std::uint32_t count;
+            std::vector<std::string> strings;
+            bool received = readNumber(connection, count);
+            for (std::uint32_t idx(0); received && idx < count; ++idx) {
+                received = readString(connection, strings.emplace_back());
+            }
+
+            if (received && !strings.empty()) {
+                const std::string workingDirectory = std::move(strings.front());
+                strings.erase(strings.begin());
+
+                std::string diagnostics;
+                const int result = handler(strings, workingDirectory, diagnostics);
+                if (writeNumber(connection, static_cast<std::uint32_t>(result))) {
+                    writeString(connection, diagnostics);
+                }
+            }
+            ::close(connection);
+        }
+    }
+
+    int runServer(const std::string &socketPath, const RequestHandler &handler) {
+        sockaddr_un address;
+        if (!makeAddress(socketPath, address)) {
+            fmt::print(stderr, "rwc: socket path {} is too long\n", socketPath);
+            return 1;
+        }
+
+        const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0) {
+            fmt::print(stderr, "rwc: could not create a socket: {}\n", std::strerror(errno));
+            return 1;
+        }
+
+        // clients going away before reading their response should not take the server down with them
+        std::signal(SIGPIPE, SIG_IGN);
+        // a previous server might have left its socket behind
+        ::unlink(socketPath.c_str());
+        if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+            fmt::print(stderr, "rwc: could not listen on {}: {}\n", socketPath, std::strerror(errno));
+            ::close(listener);
+            return 1;
+        }
+        fmt::print("rwc: listening on {}\n", socketPath);
+
+        for (;;) {
+            const int connection = ::accept(listener, nullptr, nullptr);
+            if (connection < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                fmt::print(stderr, "rwc: could not accept connections: {}\n", std::strerror(errno));
+                break;
+            }
+            std::thread(serveConnection, connection, std::cref(handler)).detach();
+        }
+
+        ::close(listener);
+        ::unlink(socketPath.c_str());
+        return 1;
+    }
+
+    std::optional<int> forwardToServer(const std::string &socketPath, int argc, const char **argv) {
+        sockaddr_un address;
+        if (!makeAddress(socketPath, address)) {
+            return std::nullopt;
+        }
+
+        const int connection = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connection < 0) {
+            return std::nullopt;
+        }
+        if (::connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(connection);
+            return std::nullopt;
+        }
+
+        llvm::SmallString<256> workingDirectory;
+        llvm::sys::fs::current_path(workingDirectory);
+
+        bool sent = writeNumber(connection, static_cast<std::uint32_t>(argc + 1)) && writeString(connection, workingDirectory.str().str());
+        for (int idx(0); sent && idx < argc; ++idx) {
+            sent = writeString(connection, argv[idx]);
+        }
+
+        std::uint32_t result;
+        std::string diagnostics;
+        const bool received = sent && readNumber(connection, result) && readString(connection, diagnostics);
+        ::close(connection);
+
+        if (!received) {
+            // the server went away while working on the request, so there's no telling what state the outputs are in
+            fmt::print(stderr, "rwc: lost the connection to the server on {}\n", socketPath);
+            return 1;
+        }
+
+        fmt::print(stderr, "{}", diagnostics);
+        return static_cast<int>(result);
+    }
+
+#else
+
+    int runServer(const std::string &, const RequestHandler &) {
+        fmt::print(stderr, "rwc: server mode is not supported on this platform\n");
+        return 1;
+    }
+
+    std::optional<int> forwardToServer(const std::string &, int, const char **) {
+        return std::nullopt;
+    }
+
+#endif
+
+}
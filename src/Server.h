@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mc {
+
+    /**
+     * @brief RequestHandler runs an rwc command line on behalf of a client.
+     * @param arguments the full command line of the client, program name included
+     * @param workingDirectory the working directory of the client
+     * @param diagnostics collects everything the client should print to its standard error
+     * @return the exit code of the client
+     */
+    using RequestHandler = std::function<int(const std::vector<std::string> &arguments, const std::string &workingDirectory, std::string &diagnostics)>;
+
+    /**
+     * @brief runServer listens on a unix socket and hands every request to handler. Requests are served concurrently, one thread each.
+     * Only returns if the socket can't be set up, or stops working.
+     */
+    int runServer(const std::string &socketPath, const RequestHandler &handler);
+
+    /**
+     * @brief forwardToServer sends a command line to a server started by runServer and waits for it to be done.
+     * @return the exit code sent by the server or nothing if no server could be reached
+     */
+    std::optional<int> forwardToServer(const std::string &socketPath, int argc, const char **argv);
+
+}
@@ -1,20 +1,49 @@
 #pragma warning(push, 0)
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/TargetSelect.h>
 #include <clang/Tooling/Tooling.h>
 #include <clang/Tooling/CommonOptionsParser.h>
 #include <clang/Frontend/CompilerInstance.h>
 #pragma warning(pop)
 
+#include <chrono>
+#include <mutex>
+#include <optional>
 #include <string> 
+#include <vector>
 #include <fmt/printf.h>
 
 #include "ClangInfrastructure.h"
+#include "IdentifierRepository.h"
+#include "JobRunner.h"
+#include "OutputCache.h"
+#include "PreambleCache.h"
+#include "Server.h"
 
 llvm::cl::OptionCategory mcOptionsCategory("mc options");
-llvm::cl::opt<std::string> mcOutput("o", llvm::cl::cat(mcOptionsCategory), llvm::cl::Required, llvm::cl::desc("cpp metadata output file"));
-llvm::cl::opt<std::string> mcModuleName("n", llvm::cl::cat(mcOptionsCategory), llvm::cl::Required, llvm::cl::desc("module name"));
-llvm::cl::opt<std::string> mcJsonOutput("j", llvm::cl::cat(mcOptionsCategory), llvm::cl::Required, llvm::cl::desc("json metadata output file"));
+llvm::cl::list<std::string> mcOutput("o", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("cpp metadata output file, one per source"));
+llvm::cl::list<std::string> mcModuleName("n", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("module name, one per source"));
+llvm::cl::list<std::string> mcDatabaseOutput("j", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("binary reflection database output file, one per source. See rosewood/database.hpp"));
+llvm::cl::list<std::string> mcDepfile("d", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("Make style depfile listing every file read while parsing a source. Either none or one per source"));
+llvm::cl::list<std::string> mcRepositoryOutput("i", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("identifier repository output file listing the descriptors generated for a source, for the modules depending on it to -import. Either none or one per source"));
+llvm::cl::list<std::string> mcSourceOutput("s", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("cpp source output defining the method, constructor, field and enumerator tables, which the -o header then only declares. Either none or one per source"));
+llvm::cl::list<std::string> mcDeclarationDirectory("declarations", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("directory receiving a header per class and enum declared in a namespace, which the -o header then only includes. Either none or one per source"));
+llvm::cl::list<std::string> mcModuleInterfaceOutput("module-interface", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("C++20 module interface unit output exporting the generated data as module <module name>.meta. Either none or one per source, not combined with -s"));
+llvm::cl::list<std::string> mcImports("import", llvm::cl::cat(mcOptionsCategory), llvm::cl::ZeroOrMore, llvm::cl::desc("identifier repository of a module the sources depend on. Its descriptors are referred to rather than generated again"));
+llvm::cl::opt<std::string> mcUmbrella("umbrella", llvm::cl::cat(mcOptionsCategory), llvm::cl::desc("parse every source at once, as part of a single translation unit, and write a source including all the cpp metadata outputs to the given path. With -d, <path>.d is its depfile"));
+llvm::cl::opt<unsigned> mcWorkerCount("workers", llvm::cl::cat(mcOptionsCategory), llvm::cl::init(0), llvm::cl::desc("number of threads used to reflect on several sources at once. 0 uses every available hardware thread"));
+llvm::cl::opt<std::string> mcSocket("socket", llvm::cl::cat(mcOptionsCategory), llvm::cl::desc("unix socket of an rwc server. The work is sent to the server if one listens on it, otherwise rwc does it by itself"));
+llvm::cl::opt<bool> mcServe("serve", llvm::cl::cat(mcOptionsCategory), llvm::cl::desc("keep running and serve the requests of rwc clients on the -socket path"));
+llvm::cl::opt<unsigned> mcPreambleCacheSize("preamble-cache-size", llvm::cl::cat(mcOptionsCategory), llvm::cl::init(256), llvm::cl::desc("maximum number of precompiled preambles kept in memory by an rwc server"));
+llvm::cl::opt<mc::FrontendProfile> mcProfile("profile", llvm::cl::cat(mcOptionsCategory), llvm::cl::init(mc::JobEnvironment{}.profile), llvm::cl::desc("how much work the compiler does while parsing sources"),
+                                            llvm::cl::values(clEnumValN(mc::FrontendProfile::Fast, "fast", "skip function bodies and warnings, which the generated data doesn't depend on"),
+                                                             clEnumValN(mc::FrontendProfile::Full, "full", "parse and analyze everything like a regular compilation")));
+llvm::cl::opt<bool> mcCompareProfiles("compare-profiles", llvm::cl::cat(mcOptionsCategory), llvm::cl::desc("parse every source with each -profile, report how long each took and whether their outputs match, then exit without writing anything"));
+llvm::cl::opt<bool> mcStatistics("stats", llvm::cl::cat(mcOptionsCategory), llvm::cl::desc("report statistics about the work done for every source, such as the hit rate of the type name cache"));
+llvm::cl::opt<bool> mcTimeTrace("time-trace", llvm::cl::cat(mcOptionsCategory), llvm::cl::desc("write a Chrome trace of the work done for every source to <output>.trace.json"));
+llvm::cl::opt<unsigned> mcTimeTraceGranularity("time-trace-granularity", llvm::cl::cat(mcOptionsCategory), llvm::cl::init(0), llvm::cl::desc("minimum duration, in microseconds, of the events recorded by -time-trace"));
+llvm::cl::opt<std::string> mcCacheDirectory("cache-dir", llvm::cl::cat(mcOptionsCategory), llvm::cl::desc("directory in which outputs are cached. A job whose preprocessed source and options were seen before gets its outputs from there instead of being parsed again"));
 
 // useful for debugging
 void printInvokation(int argc, const char **argv) {
@@ -25,17 +54,219 @@ void printInvokation(int argc, const char **argv) {
     fmt::print("\n");
 }
 
+namespace {
+
+    // llvm command line options are global so only one command line may be parsed at a time
+    std::mutex commandLineMutex;
+
+    std::string resolvePath(const std::string &workingDirectory, const std::string &path) {
+        if (workingDirectory.empty()) {
+            return path;
+        }
+        llvm::SmallString<256> absolutePath(path);
+        llvm::sys::fs::make_absolute(workingDirectory, absolutePath);
+        return absolutePath.str().str();
+    }
+
+    /**
+     * Pairs sources with the outputs in the order they were given: the first source gets the first -n, -o, -j and -d and so on.
+     * Relative paths are resolved against workingDirectory unless it's empty.
+     */
+    std::optional<std::vector<mc::ReflectionJob>> collectJobs(const std::vector<std::string> &sources, const std::string &workingDirectory, std::string &error) {
+        if (sources.empty() || mcOutput.size() != sources.size() || mcModuleName.size() != sources.size() || mcDatabaseOutput.size() != sources.size()) {
+            error = fmt::format("rwc: every source needs exactly one -n, -o and -j argument. Got {} sources, {} module names, {} outputs and {} database outputs\n",
+                                sources.size(), mcModuleName.size(), mcOutput.size(), mcDatabaseOutput.size());
+            return std::nullopt;
+        }
+        if (!mcDepfile.empty() && mcDepfile.size() != sources.size()) {
+            error = fmt::format("rwc: got {} depfiles for {} sources, -d must be given either for every source or not at all\n", mcDepfile.size(), sources.size());
+            return std::nullopt;
+        }
+        if (!mcRepositoryOutput.empty() && mcRepositoryOutput.size() != sources.size()) {
+            error = fmt::format("rwc: got {} identifier repositories for {} sources, -i must be given either for every source or not at all\n", mcRepositoryOutput.size(), sources.size());
+            return std::nullopt;
+        }
+
+        if (!mcSourceOutput.empty() && mcSourceOutput.size() != sources.size()) {
+            error = fmt::format("rwc: got {} source outputs for {} sources, -s must be given either for every source or not at all\n", mcSourceOutput.size(), sources.size());
+            return std::nullopt;
+        }
+
+        if (!mcDeclarationDirectory.empty() && mcDeclarationDirectory.size() != sources.size()) {
+            error = fmt::format("rwc: got {} declaration directories for {} sources, -declarations must be given either for every source or not at all\n", mcDeclarationDirectory.size(), sources.size());
+            return std::nullopt;
+        }
+
+        if (!mcModuleInterfaceOutput.empty() && mcModuleInterfaceOutput.size() != sources.size()) {
+            error = fmt::format("rwc: got {} module interfaces for {} sources, -module-interface must be given either for every source or not at all\n", mcModuleInterfaceOutput.size(), sources.size());
+            return std::nullopt;
+        }
+        if (!mcModuleInterfaceOutput.empty() && !mcSourceOutput.empty()) {
+            // the tables would have to be defined by a module implementation unit. Importers parse the interface once anyway
+            error = "rwc: -s and -module-interface can't be combined\n";
+            return std::nullopt;
+        }
+
+        std::vector<mc::ReflectionJob> jobs;
+        jobs.reserve(sources.size());
+        for (std::size_t idx(0); idx < sources.size(); ++idx) {
+            jobs.push_back(mc::ReflectionJob{
+                resolvePath(workingDirectory, sources[idx]),
+                mcModuleName[idx],
+                resolvePath(workingDirectory, mcOutput[idx]),
+                resolvePath(workingDirectory, mcDatabaseOutput[idx]),
+                mcDepfile.empty() ? std::string() : resolvePath(workingDirectory, mcDepfile[idx]),
+                mcRepositoryOutput.empty() ? std::string() : resolvePath(workingDirectory, mcRepositoryOutput[idx]),
+                mcSourceOutput.empty() ? std::string() : resolvePath(workingDirectory, mcSourceOutput[idx]),
+                mcDeclarationDirectory.empty() ? std::string() : resolvePath(workingDirectory, mcDeclarationDirectory[idx]),
+                mcModuleInterfaceOutput.empty() ? std::string() : resolvePath(workingDirectory, mcModuleInterfaceOutput[idx])
+            });
+        }
+        return jobs;
+    }
+
+    /**
+     * Merges the -import repositories into one. When several of them define the same identifier, the first one given wins.
+     */
+    std::optional<mc::IdentifierRepository> loadImports(const std::string &workingDirectory, std::string &error) {
+        mc::IdentifierRepository imports;
+        for (const auto &path: mcImports) {
+            const auto dependency = mc::IdentifierRepository::load(resolvePath(workingDirectory, path));
+            if (!dependency) {
+                error = fmt::format("rwc: {} is not an identifier repository\n", path);
+                return std::nullopt;
+            }
+            imports.import(*dependency);
+        }
+        return imports;
+    }
+
+    /**
+     * Runs the jobs in parallel, unless unitSource is given. They then share a single translation unit, see runUmbrellaJob.
+     */
+    int reflect(const std::vector<mc::ReflectionJob> &jobs, const clang::tooling::CompilationDatabase &compilations, unsigned workerCount, const std::string &unitSource, const mc::JobEnvironment &environment, std::vector<std::string> *diagnostics) {
+        if (unitSource.empty()) {
+            return mc::runReflectionJobs(compilations, jobs, workerCount, environment, diagnostics);
+        }
+        if (!diagnostics) {
+            return mc::runUmbrellaJob(compilations, jobs, unitSource, environment);
+        }
+        diagnostics->assign(1, std::string());
+        return mc::runUmbrellaJob(compilations, jobs, unitSource, environment, &diagnostics->front());
+    }
+
+    int compareProfiles(const std::vector<mc::ReflectionJob> &jobs, const clang::tooling::CompilationDatabase &compilations, const mc::JobEnvironment &environment) {
+        // one job at a time, so that the jobs don't skew each other's timings
+        int result = 0;
+        std::chrono::duration<double> totalFull{}, totalFast{};
+        fmt::print("{:>12} {:>12} {:>8}  {}\n", "full (ms)", "fast (ms)", "speedup", "source");
+        for (const auto &job: jobs) {
+            const auto comparison = mc::compareFrontendProfiles(compilations, job, environment);
+            if (comparison.result != 0) {
+                fmt::print(stderr, "rwc: {} failed to parse\n", job.source);
+                result = comparison.result;
+                continue;
+            }
+            fmt::print("{:>12.1f} {:>12.1f} {:>7.2f}x  {}{}\n", comparison.full.count() * 1000., comparison.fast.count() * 1000.,
+                       comparison.full / comparison.fast, job.source, comparison.identical ? "" : " (outputs differ!)");
+            if (!comparison.identical) {
+                result = 1;
+            }
+            totalFull += comparison.full;
+            totalFast += comparison.fast;
+        }
+        if (totalFast.count() > 0) {
+            fmt::print("{:>12.1f} {:>12.1f} {:>7.2f}x  total\n", totalFull.count() * 1000., totalFast.count() * 1000., totalFull / totalFast);
+        }
+        return result;
+    }
+
+    int serveRequest(const std::vector<std::string> &arguments, const std::string &workingDirectory, std::string &diagnostics, mc::PreambleCache &preambles) {
+        std::vector<const char*> argv;
+        for (const auto &argument: arguments) {
+            argv.push_back(argument.c_str());
+        }
+        int argc = static_cast<int>(argv.size());
+
+        std::unique_lock<std::mutex> lock(commandLineMutex);
+        auto options = clang::tooling::CommonOptionsParser::create(argc, argv.data(), mcOptionsCategory, llvm::cl::ZeroOrMore);
+        if (!options) {
+            diagnostics = llvm::toString(options.takeError());
+            return 1;
+        }
+        const auto jobs = collectJobs(options->getSourcePathList(), workingDirectory, diagnostics);
+        const auto imports = jobs ? loadImports(workingDirectory, diagnostics) : std::nullopt;
+        const unsigned workerCount = mcWorkerCount;
+        const std::string unitSource = mcUmbrella.empty() ? std::string() : resolvePath(workingDirectory, mcUmbrella);
+        const mc::FrontendProfile profile = mcProfile;
+        const bool statistics = mcStatistics;
+        const bool timeTrace = mcTimeTrace;
+        const unsigned timeTraceGranularity = mcTimeTraceGranularity;
+        const std::string cacheDirectory = mcCacheDirectory.empty() ? std::string() : resolvePath(workingDirectory, mcCacheDirectory);
+        lock.unlock();
+
+        if (!jobs || !imports) {
+            return 1;
+        }
+
+        std::optional<mc::OutputCache> cache;
+        if (!cacheDirectory.empty()) {
+            cache.emplace(cacheDirectory);
+        }
+
+        std::vector<std::string> jobDiagnostics;
+        const int result = reflect(*jobs, options->getCompilations(), workerCount, unitSource, mc::JobEnvironment{workingDirectory, &preambles, cache ? &*cache : nullptr, profile, statistics, timeTrace, timeTraceGranularity, &*imports}, &jobDiagnostics);
+        for (const auto &text: jobDiagnostics) {
+            diagnostics += text;
+        }
+        return result;
+    }
+
+}
+
 int main(int argc, const char **argv) {
     printInvokation(argc, argv);
 
-    clang::tooling::CommonOptionsParser OptionsParser(argc, argv, mcOptionsCategory);
-    // right now json file generation is not implemented but the interface exists so just generate a dummy file
-    std::ofstream jsonFile(mcJsonOutput);
-    jsonFile << "dummy\n";
+    // the options parser drops the compiler flags from argc but a server needs them too
+    const int fullArgc = argc;
+    clang::tooling::CommonOptionsParser OptionsParser(argc, argv, mcOptionsCategory, llvm::cl::ZeroOrMore);
+
+    if (mcServe) {
+        if (mcSocket.empty()) {
+            fmt::print(stderr, "rwc: -serve needs a -socket to listen on\n");
+            return 1;
+        }
+        mc::PreambleCache preambles(mcPreambleCacheSize);
+        return mc::runServer(mcSocket, [&preambles] (const std::vector<std::string> &arguments, const std::string &workingDirectory, std::string &diagnostics) {
+            return serveRequest(arguments, workingDirectory, diagnostics, preambles);
+        });
+    }
+
+    if (!mcSocket.empty() && !mcCompareProfiles) {
+        if (auto result = mc::forwardToServer(mcSocket, fullArgc, argv)) {
+            return *result;
+        }
+        fmt::print(stderr, "rwc: no server is listening on {}, doing all the work here\n", mcSocket.getValue());
+    }
+
+    std::string error;
+    const auto jobs = collectJobs(OptionsParser.getSourcePathList(), std::string(), error);
+    const auto imports = jobs ? loadImports(std::string(), error) : std::nullopt;
+    if (!jobs || !imports) {
+        fmt::print(stderr, "{}", error);
+        return 1;
+    }
+
+    if (mcCompareProfiles) {
+        mc::JobEnvironment environment;
+        environment.imports = &*imports;
+        return compareProfiles(*jobs, OptionsParser.getCompilations(), environment);
+    }
 
-    clang::tooling::ClangTool Tool(OptionsParser.getCompilations(), OptionsParser.getSourcePathList());
+    std::optional<mc::OutputCache> cache;
+    if (!mcCacheDirectory.empty()) {
+        cache.emplace(mcCacheDirectory);
+    }
 
-    auto fact = new mc::ActionFactory();
-    auto res = Tool.run(fact);
-    return res;
+    return reflect(*jobs, OptionsParser.getCompilations(), mcWorkerCount, mcUmbrella, mc::JobEnvironment{std::string(), nullptr, cache ? &*cache : nullptr, mcProfile, mcStatistics, mcTimeTrace, mcTimeTraceGranularity, &*imports}, nullptr);
 }
@@ -0,0 +1,23 @@
+#pragma once
+
+// reflected on with SPLIT and DECLARATION_HEADERS, see test/CMakeLists.txt
+namespace split {
+
+enum class Color {
+    red = 1,
+    green = 2
+};
+
+class Counter {
+public:
+    Counter() = default;
+
+    int add(int amount) noexcept {
+        value += amount;
+        return value;
+    }
+
+    int value = 0;
+};
+
+}
@@ -2,14 +2,24 @@
 #include "BasicDefinitions.metadata.h"
 #include "TemplateDeclarations.h"
 #include "TemplateDeclarations.metadata.h"
+#include "SplitDefinitions.h"
+// a declaration header is usable on its own
+#include "SplitDefinitions.metadata/split.Color.h"
+#include "SplitDefinitions.metadata.h"
 
 #include <rosewood/runtime.hpp>
+#include <rosewood/arena.hpp>
+#include <rosewood/constant.hpp>
+#include <rosewood/lazy.hpp>
 #include <rosewood/index.hpp>
+#include <rosewood/database.hpp>
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -44,6 +54,30 @@ TEST(mc, static_enumeration) {
     EXPECT_FALSE(enumInst.in_range(222));
 }
 
+TEST(mc, static_enumeration_lookups) {
+    // basic::Enum is too sparse for a table indexed by value, UnnamedEnum isn't
+    constexpr rosewood::meta<basic::Enum> sparse;
+    static_assert(!rosewood::meta<basic::Enum>::dense_values);
+    static_assert(sparse.to_string(basic::hundredEnumerator) == "hundredEnumerator");
+    static_assert(sparse.to_string(-30).empty());
+    static_assert(sparse.from_string("nextNegativeEnumerator") == basic::nextNegativeEnumerator);
+    static_assert(!sparse.from_string("fictionalEnumerator"));
+
+    constexpr rosewood::meta<basic::UnnamedEnum> dense;
+    static_assert(rosewood::meta<basic::UnnamedEnum>::dense_values);
+    static_assert(dense.in_range(-3) && !dense.in_range(-2) && !dense.in_range(2));
+    // unsigned values that wrap around to an enumerator once signed
+    static_assert(!dense.in_range(static_cast<unsigned>(-3)) && !dense.in_range(~0ull));
+    static_assert(dense.to_string(basic::secondOne) == "secondOne");
+    static_assert(dense.from_string("third") == basic::third);
+
+    for (const auto &enumerator: rosewood::meta<basic::Enum>::enumerators) {
+        EXPECT_EQ(sparse.to_string(enumerator.value), enumerator.name);
+        EXPECT_EQ(sparse.from_string(std::string(enumerator.name)), static_cast<basic::Enum>(enumerator.value));
+    }
+    EXPECT_FALSE(sparse.in_range(1000000000000ll));
+}
+
 
 TEST(mc, static_class_methods) {
     using PlainClass = rosewood::meta<basic::PlainClass>;
@@ -83,6 +117,45 @@ TEST(mc, static_class_fields) {
     EXPECT_EQ(expectedFields, actualFields);
 }
 
+TEST(mc, member_table) {
+    using PlainClass = rosewood::meta<basic::PlainClass>;
+    constexpr PlainClass plainClass;
+
+    static_assert (!plainClass.has_method("intField"));
+    static_assert (plainClass.find_member("intField")->kind == rosewood::MemberKind::Field);
+    static_assert (plainClass.find_member("innerEnum")->kind == rosewood::MemberKind::Enum);
+    static_assert (plainClass.find_member("overloadedMethod")->kind == rosewood::MemberKind::Method);
+    static_assert (!plainClass.find_member("privateFloatMember"));
+    static_assert (!plainClass.find_member(""));
+
+    // a name with the hash of a member lands in its slot, and is still told apart from it
+    constexpr const auto &table = PlainClass::member_table;
+    static_assert (!table.find(rosewood::hashed_name("intFielx", rosewood::hash_name("intField"))));
+
+    // so is a name of another hash that the displacement of its bucket sends to an occupied slot
+    bool collided = false;
+    for (int candidate = 0; candidate < 1000 && !collided; ++candidate) {
+        const std::string name = "missing" + std::to_string(candidate);
+        const rosewood::hashed_name hashed(name);
+        const std::uint32_t displacement = table.displacements[rosewood::detail::perfect_hash_bucket(hashed.hash, table.displacements.size())];
+        const std::size_t slot = rosewood::detail::perfect_hash_slot(hashed.hash, displacement, table.slots.size());
+        if (table.slots[slot].kind != rosewood::MemberKind::None) {
+            collided = true;
+            EXPECT_EQ(table.find(hashed), nullptr);
+        }
+    }
+    EXPECT_TRUE(collided);
+
+    // the runtime model finds the declarations of a class through the same table
+    const rosewood::DNamespaceWrapper basicDefs(rosewood::meta_BasicDefinitions{}, nullptr);
+    const auto plainClss = basicDefs.getDeclaration("basic")->asNamespace()->getDeclaration("PlainClass")->asClass();
+    ASSERT_TRUE(plainClss);
+    EXPECT_TRUE(plainClss->getDeclaration("overloadedMethod")->asMethod()->getNextOverload() != nullptr);
+    EXPECT_TRUE(plainClss->getDeclaration("innerEnum")->asEnum() != nullptr);
+    EXPECT_EQ(plainClss->getDeclaration("privateFloatMember"), nullptr);
+    EXPECT_EQ(plainClss->getDeclaration(""), nullptr);
+}
+
 
 
 TEST(mc, runtime_module) {
@@ -156,6 +229,40 @@ TEST(mc, string_wrap) {
     EXPECT_EQ(testString, res);
 }
 
+TEST(mc, type_lists) {
+    static_assert(std::is_same_v<rosewood::concatenate_tuples<>::type, std::tuple<>>);
+    static_assert(std::is_same_v<rosewood::concatenate_tuples<std::tuple<int>, std::tuple<>, std::tuple<char, float>>::type, std::tuple<int, char, float>>);
+    static_assert(std::is_same_v<rosewood::arguments_wrapper<rosewood::FunctionParameter, std::tuple<>, int, const char*>::type,
+                                 std::tuple<rosewood::FunctionParameter<int>, rosewood::FunctionParameter<const char*>>>);
+    static_assert(std::is_same_v<rosewood::tuple_elements_wrapper<std::add_const_t, std::tuple<char>, std::tuple<int, float>>::type,
+                                 std::tuple<char, const int, const float>>);
+    EXPECT_EQ((rosewood::MethodDeclaration<basic::PlainClass, int, true, false, int, double>::num_args), 2u);
+}
+
+TEST(mc, split_tables) {
+    // only the descriptors are in the header, their tables are compiled with SplitDefinitions.metadata.cpp
+    static_assert(rosewood::meta<split::Counter>::name == "Counter");
+    EXPECT_TRUE(rosewood::meta<split::Color>{}.in_range(2));
+    EXPECT_FALSE(rosewood::meta<split::Color>{}.in_range(3));
+    EXPECT_EQ(rosewood::meta<split::Color>{}.to_string(split::Color::green), "green");
+    EXPECT_EQ(rosewood::meta<split::Color>{}.from_string("red"), split::Color::red);
+
+    constexpr rosewood::meta_SplitDefinitions sd;
+    rosewood::DNamespaceWrapper module(sd, nullptr);
+    auto counterClass = module.getDeclaration("split")->asNamespace()->getDeclaration("Counter")->asClass();
+    ASSERT_TRUE(counterClass != nullptr);
+
+    split::Counter counter;
+    int amount = 3, result = 0;
+    void *args[] = {&amount};
+    counterClass->getDeclaration("add")->asMethod()->call(&counter, &result, args);
+    EXPECT_EQ(result, 3);
+
+    int value = 10;
+    counterClass->getDeclaration("value")->asField()->assign_copy(&counter, &value);
+    EXPECT_EQ(counter.value, 10);
+}
+
 TEST(mc, index) {
     using Index = rosewood::StaticIndex<rosewood::meta_BasicDefinitions, rosewood::meta_TemplateDeclarations>;
     Index index;
@@ -182,3 +289,291 @@ TEST(mc, index) {
     otherMethod.invoke(&plainClass, &returnSlot, argsArray);
     EXPECT_EQ(returnSlot, plainClass.doubleInteger(argValue));
 }
+
+TEST(mc, qualified_name_table) {
+    using Index = rosewood::StaticIndex<rosewood::meta_BasicDefinitions, rosewood::meta_TemplateDeclarations>;
+
+    for (const auto hashing: {rosewood::QualifiedNameTable::Hashing::Linear, rosewood::QualifiedNameTable::Hashing::Perfect}) {
+        const Index flattened(hashing);
+        EXPECT_EQ(flattened.names().isPerfect(), hashing == rosewood::QualifiedNameTable::Hashing::Perfect);
+        const auto indexedClass = flattened.getDeclaration("basic::PlainClass");
+        ASSERT_TRUE(indexedClass && indexedClass->asClass());
+        EXPECT_EQ(indexedClass->parent(), flattened.getDeclaration("basic")->asNamespace());
+        EXPECT_TRUE(flattened.getDeclaration("basic::PlainClass::doubleInteger")->asMethod());
+        EXPECT_TRUE(flattened.getDeclaration("basic::PlainClass::intField")->asField());
+        EXPECT_TRUE(flattened.getDeclaration("basic::PlainClass::innerEnum")->asEnum());
+        EXPECT_EQ(flattened.getDeclaration("basic::Enum::negativeEnumerator")->asEnumerator()->getValue(), basic::negativeEnumerator);
+        EXPECT_TRUE(flattened.getDeclaration("td::SimpleTemplateInstance"));
+        EXPECT_EQ(flattened.getDeclaration("PlainClass"), nullptr);
+        EXPECT_EQ(flattened.getDeclaration("basic::PlainClass::privateFloatMember"), nullptr);
+        EXPECT_EQ(flattened.getDeclaration("basic::unthinkable"), nullptr);
+        // the slot of basic::PlainClass, which holds another name
+        EXPECT_EQ(flattened.names().find(rosewood::hashed_name("basic::PlainClasz", rosewood::hash_name("basic::PlainClass"))), nullptr);
+    }
+
+    // enough names for linear probing to run into occupied slots
+    const rosewood::DNamespaceWrapper basicDefs(rosewood::meta_BasicDefinitions{}, nullptr);
+    const rosewood::Declaration *declarations[] = {basicDefs.getDeclaration("basic"), &basicDefs};
+    for (const auto hashing: {rosewood::QualifiedNameTable::Hashing::Linear, rosewood::QualifiedNameTable::Hashing::Perfect}) {
+        rosewood::QualifiedNameTable table;
+        for (int index = 0; index < 500; ++index) {
+            table.add("ns::Class" + std::to_string(index), declarations[index % 2]);
+        }
+        table.add("ns::Class0", declarations[1]);
+        EXPECT_EQ(table.find(rosewood::hashed_name("ns::Class0")), nullptr);
+        table.build(hashing);
+
+        EXPECT_EQ(table.size(), 500u);
+        EXPECT_EQ(table.isPerfect(), hashing == rosewood::QualifiedNameTable::Hashing::Perfect);
+        for (int index = 0; index < 500; ++index) {
+            EXPECT_EQ(table.find(rosewood::hashed_name("ns::Class" + std::to_string(index))), declarations[index % 2]);
+            EXPECT_EQ(table.find(rosewood::hashed_name("ns::Struct" + std::to_string(index))), nullptr);
+        }
+        EXPECT_EQ(table.find(rosewood::hashed_name("ns::Class500")), nullptr);
+        EXPECT_EQ(table.find(rosewood::hashed_name("ns::Class1", rosewood::hash_name("ns::Class0"))), nullptr);
+    }
+}
+
+TEST(mc, checked_calls) {
+    const rosewood::DNamespaceWrapper basicDefs(rosewood::meta_BasicDefinitions{}, nullptr);
+    const auto plainClass = basicDefs.getDeclaration("basic")->asNamespace()->getDeclaration("PlainClass")->asClass();
+    const auto doubleInteger = plainClass->getDeclaration("doubleInteger")->asMethod();
+    ASSERT_TRUE(doubleInteger);
+
+    EXPECT_EQ(doubleInteger->getReturnType()->getTypeId(), rosewood::type_id_of<int>());
+    EXPECT_EQ(doubleInteger->getReturnType()->getName(), "int");
+    ASSERT_EQ(doubleInteger->getParameterCount(), 1u);
+    EXPECT_EQ(doubleInteger->getParameter(0)->getName(), "namedParam");
+    EXPECT_EQ(doubleInteger->getParameter(0)->getType()->getTypeId(), rosewood::type_id_of<int>());
+    EXPECT_EQ(doubleInteger->getParameter(1), nullptr);
+    EXPECT_EQ(plainClass->getDeclaration("floatField")->asField()->getType()->getTypeId(), rosewood::type_id_of<float>());
+    EXPECT_NE(rosewood::type_id_of<int>(), rosewood::type_id_of<float>());
+
+    // the types of the objects the arguments point to are what matters
+    const auto signature = rosewood::signature_of<int, int>();
+    EXPECT_EQ(signature, (rosewood::signature_of<const int, const int&>()));
+    EXPECT_TRUE(doubleInteger->hasSignature(signature));
+
+    basic::PlainClass object;
+    int result = 0;
+    int argument = 21;
+    void *args[] = {&argument};
+    doubleInteger->checked_call(&object, &result, args, signature);
+    EXPECT_EQ(result, object.doubleInteger(argument));
+    EXPECT_THROW(doubleInteger->checked_call(&object, &result, args, rosewood::signature_of<int, double>()), rosewood::signature_error);
+    EXPECT_THROW(doubleInteger->checked_call(&object, &result, args, rosewood::signature_of<void, int>()), rosewood::signature_error);
+
+    const auto overloaded = plainClass->getDeclaration("overloadedMethod")->asMethod();
+    const auto withInt = overloaded->findOverload(rosewood::signature_of<void, int>());
+    ASSERT_TRUE(withInt);
+    EXPECT_EQ(withInt->getParameterCount(), 1u);
+    EXPECT_TRUE(overloaded->findOverload(rosewood::signature_of<void>()));
+    EXPECT_EQ(overloaded->findOverload(rosewood::signature_of<int>()), nullptr);
+}
+
+TEST(mc, hashed_names) {
+    using namespace rosewood::literals;
+    static_assert("doubleInteger"_name.hash == rosewood::hash_name("doubleInteger"));
+    static_assert(rosewood::meta_BasicDefinitions::name_hash == rosewood::hash_name("BasicDefinitions"));
+    static_assert(rosewood::meta<basic::PlainClass>::member_table.find("doubleInteger"_name)->kind == rosewood::MemberKind::Method);
+    static_assert(!rosewood::meta<basic::PlainClass>::member_table.find(rosewood::hashed_name("doubleInteger", 0)));
+
+    const rosewood::DNamespaceWrapper module(rosewood::meta_BasicDefinitions{}, nullptr);
+    const rosewood::DeclarationContext &context = module;
+    const auto basicNamespace = context.getDeclaration("basic"_name);
+    ASSERT_TRUE(basicNamespace);
+    EXPECT_EQ(basicNamespace, context.getDeclaration("basic"));
+
+    const auto plainClass = basicNamespace->asNamespace()->getDeclaration("PlainClass"_name)->asClass();
+    ASSERT_TRUE(plainClass);
+    const std::string fieldName = "intField";
+    const rosewood::hashed_name dynamicName(fieldName);
+    EXPECT_EQ(plainClass->getDeclaration(dynamicName), plainClass->getDeclaration("intField"));
+    EXPECT_TRUE(plainClass->getDeclaration("innerEnum"_name)->asEnum()->getDeclaration("secondOne"_name));
+    EXPECT_EQ(plainClass->getDeclaration("privateFloatMember"_name), nullptr);
+}
+
+TEST(mc, name_ids) {
+    rosewood::NameTable &names = rosewood::NameTable::global();
+    const rosewood::DNamespaceWrapper module(rosewood::meta_BasicDefinitions{}, nullptr);
+    const rosewood::DeclarationContext &context = module;
+
+    // building the model interns nothing, the names are given their ids here
+    EXPECT_EQ(names.find("neverInterned"), rosewood::no_name);
+    const auto basicId = names.intern("basic");
+    const auto plainClassId = names.intern("PlainClass");
+    const auto doubleIntegerId = names.intern("doubleInteger");
+    ASSERT_NE(basicId, rosewood::no_name);
+    EXPECT_EQ(names.find("basic"), basicId);
+    EXPECT_EQ(names.name(doubleIntegerId).name, "doubleInteger");
+
+    const auto basicNamespace = context.getDeclaration(basicId);
+    ASSERT_TRUE(basicNamespace);
+    EXPECT_EQ(basicNamespace, context.getDeclaration("basic"));
+    EXPECT_TRUE(basicNamespace->isCalled(basicId));
+    EXPECT_FALSE(basicNamespace->isCalled(plainClassId));
+
+    const auto plainClass = basicNamespace->asNamespace()->getDeclaration(plainClassId)->asClass();
+    ASSERT_TRUE(plainClass);
+    const auto doubleInteger = plainClass->getDeclaration(doubleIntegerId);
+    EXPECT_EQ(doubleInteger, plainClass->getDeclaration("doubleInteger"));
+    EXPECT_TRUE(doubleInteger->isCalled(doubleIntegerId));
+    EXPECT_TRUE(plainClass->getDeclaration(names.intern("innerEnum"))->asEnum()->getDeclaration(names.intern("secondOne"))->asEnumerator());
+    EXPECT_EQ(plainClass->getDeclaration(basicId), nullptr);
+    EXPECT_EQ(context.getDeclaration(rosewood::no_name), nullptr);
+
+    // contexts without ids of their own look the name up
+    const rosewood::LazyNamespaceWrapper lazy(rosewood::meta_BasicDefinitions{}, nullptr);
+    EXPECT_TRUE(lazy.getDeclaration(basicId)->asNamespace()->getDeclaration(plainClassId)->isCalled(plainClassId));
+}
+
+// the checks the arena and constant models share, their declarations and members have the same interface
+template <typename Model>
+void expectBasicDefinitions(const Model &model) {
+    EXPECT_EQ(model.getModule().getName(), "BasicDefinitions");
+
+    const auto plainClass = model.getDeclaration("basic::PlainClass");
+    ASSERT_TRUE(plainClass);
+    EXPECT_EQ(plainClass.getKind(), rosewood::db::DeclarationKind::Class);
+    EXPECT_EQ(plainClass.parent().getName(), "basic");
+    EXPECT_EQ(plainClass.getDeclaration("innerEnum").getKind(), rosewood::db::DeclarationKind::Enum);
+    EXPECT_EQ(plainClass.getMembers("overloadedMethod").size(), 2u);
+    EXPECT_TRUE(plainClass.getMember("constNoExceptFunction").isNoexcept());
+    EXPECT_FALSE(plainClass.getMember("privateFloatMember"));
+
+    basic::PlainClass object;
+    int argument = 12, result = 0;
+    void *arguments[] = {&argument};
+    const auto doubleInteger = plainClass.getMember("doubleInteger");
+    ASSERT_TRUE(doubleInteger);
+    EXPECT_TRUE(doubleInteger.isConst());
+    doubleInteger.call(&static_cast<const basic::PlainClass&>(object), &result, arguments);
+    EXPECT_EQ(result, object.doubleInteger(argument));
+    EXPECT_THROW(plainClass.getMember("noArgsNoReturnMethod").call(&static_cast<const basic::PlainClass&>(object), nullptr, nullptr), rosewood::const_corectness_error);
+
+    int value = 1337;
+    plainClass.getMember("intField").assign_copy(&object, &value);
+    EXPECT_EQ(object.intField, value);
+
+    const auto enumeration = model.getDeclaration("basic::Enum");
+    ASSERT_TRUE(enumeration);
+    EXPECT_EQ(enumeration.members().size(), 5u);
+    EXPECT_EQ(enumeration.getMember("negativeEnumerator").getValue(), basic::negativeEnumerator);
+    EXPECT_FALSE(model.getDeclaration("basic::unthinkable"));
+}
+
+TEST(mc, arena_model) {
+    const rosewood::ArenaModel model(rosewood::meta_BasicDefinitions{});
+    expectBasicDefinitions(model);
+}
+
+TEST(mc, constant_model) {
+    // the model and its records are constants, nothing is built at run time
+    constexpr const rosewood::ConstantModel &model = rosewood::constant_model<rosewood::meta_BasicDefinitions>;
+    constexpr const auto &records = rosewood::detail::constant_model_records<rosewood::meta_BasicDefinitions>::records;
+    static_assert(records.declarations[0].name == "BasicDefinitions");
+    static_assert(records.declarations[0].kind == rosewood::db::DeclarationKind::Module);
+    expectBasicDefinitions(model);
+
+    // members are only found by their own declaration
+    const auto plainClass = model.getDeclaration("basic::PlainClass");
+    EXPECT_FALSE(plainClass.getMember("innerEnum"));
+    EXPECT_FALSE(model.getDeclaration("basic::PlainClass::intField"));
+
+    // the overloads of a member are stored next to each other
+    const auto overloads = plainClass.getMembers("overloadedMethod");
+    ASSERT_EQ(overloads.size(), 2u);
+    EXPECT_EQ(overloads[0].getName(), "overloadedMethod");
+    EXPECT_EQ(overloads[1].getName(), "overloadedMethod");
+    EXPECT_EQ(overloads[0].getKind(), rosewood::db::MemberKind::Method);
+    EXPECT_EQ(overloads[1].getKind(), rosewood::db::MemberKind::Method);
+
+    // the out of line tables of split definitions are only known at run time, the model still refers to them
+    const auto color = rosewood::constant_model<rosewood::meta_SplitDefinitions>.getDeclaration("split::Color");
+    ASSERT_TRUE(color);
+    EXPECT_EQ(color.getMember("green").getValue(), static_cast<std::int64_t>(split::Color::green));
+    EXPECT_EQ(color.getMember("red").getName(), "red");
+
+    split::Counter counter;
+    int amount = 3, result = 0;
+    void *args[] = {&amount};
+    rosewood::constant_model<rosewood::meta_SplitDefinitions>.getDeclaration("split::Counter").getMember("add").call(&counter, &result, args);
+    EXPECT_EQ(counter.value, amount);
+}
+
+TEST(mc, lazy_model) {
+    const rosewood::LazyNamespaceWrapper model(rosewood::meta_BasicDefinitions{}, nullptr);
+    const auto basicNamespace = dynamic_cast<const rosewood::DNamespace*>(model.getDeclaration("basic"));
+    ASSERT_TRUE(basicNamespace);
+    EXPECT_EQ(model.getDeclaration("basic"), basicNamespace);
+    EXPECT_EQ(model.getDeclaration("unthinkable"), nullptr);
+
+    const auto plainClass = dynamic_cast<const rosewood::Class*>(basicNamespace->getDeclaration("PlainClass"));
+    ASSERT_TRUE(plainClass);
+    EXPECT_EQ(plainClass->parent(), basicNamespace);
+    const auto overloadedMethod = dynamic_cast<const rosewood::DMethod*>(plainClass->getDeclaration("overloadedMethod"));
+    ASSERT_TRUE(overloadedMethod);
+    EXPECT_TRUE(overloadedMethod->getNextOverload());
+    EXPECT_TRUE(plainClass->getDeclaration("intField"));
+    EXPECT_EQ(plainClass->getDeclaration("privateFloatMember"), nullptr);
+
+    const auto innerEnum = dynamic_cast<const rosewood::DEnum*>(plainClass->getDeclaration("innerEnum"));
+    ASSERT_TRUE(innerEnum);
+    EXPECT_EQ(innerEnum->parent(), plainClass);
+
+    const auto enumeration = dynamic_cast<const rosewood::DEnum*>(basicNamespace->getDeclaration("Enum"));
+    ASSERT_TRUE(enumeration);
+    EXPECT_TRUE(enumeration->getDeclaration("negativeEnumerator"));
+    EXPECT_EQ(enumeration->getDeclaration("unthinkable"), nullptr);
+
+    const rosewood::LazyNamespaceWrapper fresh(rosewood::meta_BasicDefinitions{}, nullptr);
+    std::vector<const rosewood::Declaration*> found(8);
+    std::vector<std::thread> threads;
+    for (std::size_t idx(0); idx < found.size(); ++idx) {
+        threads.emplace_back([&fresh, &found, idx] {
+            found[idx] = fresh.getDeclaration("basic");
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(found.front());
+    for (const auto declaration: found) {
+        EXPECT_EQ(declaration, found.front());
+    }
+}
+
+TEST(mc, database) {
+    const rosewood::Database database(RWTEST_BASIC_DEFINITIONS_DATABASE);
+    EXPECT_EQ(database.getModule().getName(), "BasicDefinitions");
+
+    const auto plainClass = database.getDeclaration("basic::PlainClass");
+    ASSERT_TRUE(plainClass);
+    EXPECT_EQ(plainClass.getKind(), rosewood::db::DeclarationKind::Class);
+    EXPECT_EQ(plainClass.getQualifiedName(), "basic::PlainClass");
+    EXPECT_EQ(plainClass.parent().getName(), "basic");
+    EXPECT_EQ(plainClass.getDeclaration("innerEnum").getKind(), rosewood::db::DeclarationKind::Enum);
+
+    const auto doubleInteger = plainClass.getMember("doubleInteger");
+    ASSERT_TRUE(doubleInteger);
+    EXPECT_EQ(doubleInteger.getKind(), rosewood::db::MemberKind::Method);
+    EXPECT_TRUE(doubleInteger.isConst());
+    EXPECT_EQ(doubleInteger.getType().getName(), "int");
+    ASSERT_EQ(doubleInteger.parameters().size(), 1u);
+    EXPECT_EQ(doubleInteger.parameters()[0].getName(), "namedParam");
+
+    EXPECT_EQ(plainClass.getMembers("overloadedMethod").size(), 2u);
+    EXPECT_TRUE(plainClass.getMember("constNoExceptFunction").isNoexcept());
+    EXPECT_FALSE(plainClass.getMember("privateFloatMember"));
+
+    const auto podStruct = database.getDeclaration("basic::podStruct");
+    EXPECT_EQ(podStruct.getMember("longField").getValue(), static_cast<std::int64_t>(offsetof(basic::podStruct, longField)));
+
+    const auto enumeration = database.getDeclaration("basic::Enum");
+    ASSERT_TRUE(enumeration);
+    EXPECT_EQ(enumeration.members().size(), 5u);
+    EXPECT_EQ(enumeration.getMember("negativeEnumerator").getValue(), basic::negativeEnumerator);
+
+    EXPECT_FALSE(database.getDeclaration("basic::unthinkable"));
+    EXPECT_FALSE(database.getDeclaration("unthinkable::PlainClass"));
+}
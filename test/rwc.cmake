@@ -0,0 +1,252 @@
+# Runs rwc on headers written to WORK_DIR and checks what it generates, one case per rwc_<case> test of test/CMakeLists.txt:
+#   cmake -DRWC=<path to rwc> -DWORK_DIR=<scratch directory> -DCASE=<case> -P rwc.cmake
+cmake_minimum_required(VERSION 3.9)
+
+foreach(variable RWC WORK_DIR CASE)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "rwc.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+# the reflected headers include nothing but one another, so no system include directory is needed
+set(compilerArguments -- -x c++ -std=c++17 -fsyntax-only -Wno-pragma-once-outside-header -nobuiltininc)
+
+# runs rwc with ARGN, rwcErrors gets what it reported on stderr, which -stats writes to for every source that wasn't a cache hit
+function(run_rwc)
+    execute_process(COMMAND ${RWC} ${ARGN} ${compilerArguments}
+        WORKING_DIRECTORY ${WORK_DIR}
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "rwc ${ARGN} failed with ${result}:\n${output}${errors}")
+    endif()
+    set(rwcErrors "${errors}" PARENT_SCOPE)
+endfunction()
+
+# runs cmake with ARGN, to configure and build projects using the CMake functions of rosewood
+function(run_cmake)
+    execute_process(COMMAND ${CMAKE_COMMAND} ${ARGN}
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "cmake ${ARGN} failed with ${result}:\n${output}${errors}")
+    endif()
+endfunction()
+
+function(expect_contains path text)
+    if (NOT EXISTS ${path})
+        message(FATAL_ERROR "${path} wasn't generated")
+    endif()
+    file(READ ${path} contents)
+    string(FIND "${contents}" "${text}" position)
+    if (position EQUAL -1)
+        message(FATAL_ERROR "${path} doesn't contain '${text}':\n${contents}")
+    endif()
+endfunction()
+
+function(expect_lacks path text)
+    file(READ ${path} contents)
+    string(FIND "${contents}" "${text}" position)
+    if (NOT position EQUAL -1)
+        message(FATAL_ERROR "${path} contains '${text}':\n${contents}")
+    endif()
+endfunction()
+
+function(expect_cache_miss expected)
+    string(FIND "${rwcErrors}" "type names looked up" position)
+    if (expected AND position EQUAL -1)
+        message(FATAL_ERROR "expected rwc to parse the source again, it reported:\n${rwcErrors}")
+    elseif (NOT expected AND NOT position EQUAL -1)
+        message(FATAL_ERROR "expected rwc to take the outputs from its cache, it reported:\n${rwcErrors}")
+    endif()
+endfunction()
+
+function(modification_time outVar path)
+    file(TIMESTAMP ${path} time "%s")
+    set(${outVar} ${time} PARENT_SCOPE)
+endfunction()
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+if (CASE STREQUAL "cache")
+    # outputs are cached by the tokens of the source and the files they come from, see -cache-dir
+    file(WRITE ${WORK_DIR}/Included.h "#pragma once\nnamespace cached { struct Helper { int value; }; }\n")
+    file(WRITE ${WORK_DIR}/Cached.h "#pragma once\n#include \"Included.h\"\nnamespace cached { struct Moved { int weight; }; }\nnamespace cached { struct Widget { int size; }; }\n")
+    set(output ${WORK_DIR}/Cached.metadata.h)
+    set(depfile ${WORK_DIR}/Cached.metadata.d)
+    set(arguments ${WORK_DIR}/Cached.h -n Cached -o ${output} -j ${WORK_DIR}/Cached.metadata.rwdb -d ${depfile} -cache-dir ${WORK_DIR}/cache -stats)
+
+    run_rwc(${arguments})
+    expect_cache_miss(TRUE)
+    expect_contains(${output} "struct meta_Widget")
+    expect_contains(${output} "struct meta_Moved")
+    expect_lacks(${output} "struct meta_Helper")
+    modification_time(generatedAt ${output})
+
+    # timestamps have a resolution of a second, a rewrite would show after this
+    execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 2)
+    file(APPEND ${WORK_DIR}/Cached.h "// comments aren't tokens, the outputs stay as they are\n")
+    run_rwc(${arguments})
+    expect_cache_miss(FALSE)
+    modification_time(regeneratedAt ${output})
+    if (NOT generatedAt EQUAL regeneratedAt)
+        message(FATAL_ERROR "${output} was written again although only a comment changed")
+    endif()
+    # a hit writes the depfile again, from the files the tokens came from
+    expect_contains(${depfile} "Included.h")
+
+    # the very same tokens, but Moved now comes from another file and is no longer reflected on
+    file(WRITE ${WORK_DIR}/Included.h "#pragma once\nnamespace cached { struct Helper { int value; }; }\nnamespace cached { struct Moved { int weight; }; }\n")
+    file(WRITE ${WORK_DIR}/Cached.h "#pragma once\n#include \"Included.h\"\nnamespace cached { struct Widget { int size; }; }\n")
+    run_rwc(${arguments})
+    expect_cache_miss(TRUE)
+    expect_contains(${output} "struct meta_Widget")
+    expect_lacks(${output} "struct meta_Moved")
+
+elseif (CASE STREQUAL "batch")
+    # several sources in one invocation: each gets outputs of its own, with its own declarations only
+    file(WRITE ${WORK_DIR}/First.h "#pragma once\nnamespace batch { struct First { int first; }; }\n")
+    file(WRITE ${WORK_DIR}/Second.h "#pragma once\n#include \"First.h\"\nnamespace batch { struct Second { First inner; }; enum class Order { one, two }; }\n")
+    run_rwc(${WORK_DIR}/First.h -n First -o ${WORK_DIR}/First.metadata.h -j ${WORK_DIR}/First.metadata.rwdb
+            ${WORK_DIR}/Second.h -n Second -o ${WORK_DIR}/Second.metadata.h -j ${WORK_DIR}/Second.metadata.rwdb
+            -workers 2)
+
+    expect_contains(${WORK_DIR}/First.metadata.h "struct meta_First")
+    expect_lacks(${WORK_DIR}/First.metadata.h "struct meta_Second")
+    expect_contains(${WORK_DIR}/Second.metadata.h "struct meta_Second")
+    expect_contains(${WORK_DIR}/Second.metadata.h "struct meta_Order")
+    expect_lacks(${WORK_DIR}/Second.metadata.h "struct meta_First")
+    foreach(name First Second)
+        if (NOT EXISTS ${WORK_DIR}/${name}.metadata.rwdb)
+            message(FATAL_ERROR "no database was written for ${name}.h")
+        endif()
+    endforeach()
+
+elseif (CASE STREQUAL "server_fallback")
+    # with no server on -socket, rwc does the work by itself. Relative to WORK_DIR, the path stays short enough for a socket
+    file(WRITE ${WORK_DIR}/Served.h "#pragma once\nnamespace served { struct Request { int id; }; }\n")
+    run_rwc(${WORK_DIR}/Served.h -n Served -o ${WORK_DIR}/Served.metadata.h -j ${WORK_DIR}/Served.metadata.rwdb -socket rwc.sock)
+    string(FIND "${rwcErrors}" "no server is listening" position)
+    if (position EQUAL -1)
+        message(FATAL_ERROR "rwc didn't report the missing server:\n${rwcErrors}")
+    endif()
+    expect_contains(${WORK_DIR}/Served.metadata.h "struct meta_Request")
+
+elseif (CASE STREQUAL "depfiles")
+    # the rule of every output lists its reflected header and every file the preprocessor opened for it
+    file(WRITE ${WORK_DIR}/Leaf.h "#pragma once\nnamespace deps { struct Leaf { int value; }; }\n")
+    file(WRITE ${WORK_DIR}/Middle.h "#pragma once\n#include \"Leaf.h\"\n")
+    file(WRITE ${WORK_DIR}/Tracked.h "#pragma once\n#include \"Middle.h\"\nnamespace deps { struct Tracked { Leaf leaf; }; }\n")
+    file(WRITE ${WORK_DIR}/Other.h "#pragma once\nnamespace deps { struct Other { int value; }; }\n")
+    run_rwc(${WORK_DIR}/Tracked.h -n Tracked -o ${WORK_DIR}/Tracked.metadata.h -j ${WORK_DIR}/Tracked.metadata.rwdb -d ${WORK_DIR}/Tracked.metadata.d
+            ${WORK_DIR}/Other.h -n Other -o ${WORK_DIR}/Other.metadata.h -j ${WORK_DIR}/Other.metadata.rwdb -d ${WORK_DIR}/Other.metadata.d)
+    expect_contains(${WORK_DIR}/Tracked.metadata.d "Tracked.metadata.h:")
+    foreach(dependency Tracked.h Middle.h Leaf.h)
+        expect_contains(${WORK_DIR}/Tracked.metadata.d "${dependency}")
+    endforeach()
+    expect_contains(${WORK_DIR}/Other.metadata.d "Other.metadata.h:")
+    expect_contains(${WORK_DIR}/Other.metadata.d "Other.h")
+    expect_lacks(${WORK_DIR}/Other.metadata.d "Leaf.h")
+
+elseif (CASE STREQUAL "umbrella")
+    # the sources of a target are parsed as one umbrella unit, and the single unit generated for them includes every output
+    file(WRITE ${WORK_DIR}/First.h "#pragma once\nnamespace batch { struct First { int first; }; }\n")
+    file(WRITE ${WORK_DIR}/Detail.h "#pragma once\nnamespace batch { using Weight = float; }\n")
+    file(WRITE ${WORK_DIR}/Second.h "#pragma once\n#include \"First.h\"\n#include \"Detail.h\"\nnamespace batch { struct Second { First inner; Weight weight; }; enum class Order { one, two }; }\n")
+    run_rwc(${WORK_DIR}/First.h -n First -o ${WORK_DIR}/First.metadata.h -j ${WORK_DIR}/First.metadata.rwdb -d ${WORK_DIR}/First.metadata.d
+            ${WORK_DIR}/Second.h -n Second -o ${WORK_DIR}/Second.metadata.h -j ${WORK_DIR}/Second.metadata.rwdb -d ${WORK_DIR}/Second.metadata.d
+            -umbrella ${WORK_DIR}/Unit.cpp)
+    expect_contains(${WORK_DIR}/Unit.cpp "First.metadata.h\"")
+    expect_contains(${WORK_DIR}/Unit.cpp "Second.metadata.h\"")
+    expect_contains(${WORK_DIR}/First.metadata.h "struct meta_First")
+    expect_lacks(${WORK_DIR}/First.metadata.h "struct meta_Second")
+    expect_contains(${WORK_DIR}/Second.metadata.h "struct meta_Second")
+    expect_lacks(${WORK_DIR}/Second.metadata.h "struct meta_First")
+    # the unit has a depfile of its own, naming it and listing what every source includes
+    expect_contains(${WORK_DIR}/Unit.cpp.d "Unit.cpp:")
+    foreach(dependency First.h Second.h Detail.h)
+        expect_contains(${WORK_DIR}/Unit.cpp.d "${dependency}")
+    endforeach()
+
+elseif (CASE STREQUAL "single_invocation")
+    # rosewood_reflect_on_headers runs rwc once for all of the headers of a target. A change to a header only the second of them
+    # includes must bring its output up to date all the same. Needs ROSEWOOD_DIR, the root of this repository, and GENERATOR
+    foreach(variable ROSEWOOD_DIR GENERATOR)
+        if (NOT DEFINED ${variable})
+            message(FATAL_ERROR "rwc.cmake: ${variable} is not set")
+        endif()
+    endforeach()
+    file(WRITE ${WORK_DIR}/project/First.h "#pragma once\nnamespace single { struct First { int first; }; }\n")
+    file(WRITE ${WORK_DIR}/project/Field.h "#pragma once\n#define SECOND_FIELD before\n")
+    file(WRITE ${WORK_DIR}/project/Second.h "#pragma once\n#include \"Field.h\"\nnamespace single { struct Second { int SECOND_FIELD; }; }\n")
+    file(WRITE ${WORK_DIR}/project/Reflected.cpp "#include \"Second.h\"\n")
+    file(WRITE ${WORK_DIR}/project/CMakeLists.txt "cmake_minimum_required(VERSION 3.9)
+project(single_invocation CXX)
+include(${ROSEWOOD_DIR}/cmake/rosewood.cmake)
+add_executable(rwc IMPORTED)
+set_target_properties(rwc PROPERTIES IMPORTED_LOCATION ${RWC})
+add_library(rwruntime INTERFACE)
+target_include_directories(rwruntime INTERFACE ${ROSEWOOD_DIR}/include)
+add_library(reflected STATIC Reflected.cpp)
+set_target_properties(reflected PROPERTIES CXX_STANDARD 17)
+rosewood_reflect_on_headers(reflected reflected_metadata First.h Second.h SINGLE_INVOCATION)
+")
+    set(output ${WORK_DIR}/build/Second.metadata.h)
+    run_cmake(-S ${WORK_DIR}/project -B ${WORK_DIR}/build -G ${GENERATOR})
+    run_cmake(--build ${WORK_DIR}/build --target reflected_metadata)
+    expect_contains(${output} "\"before\"")
+
+    # timestamps have a resolution of a second, the edit would go unnoticed otherwise
+    execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 2)
+    file(WRITE ${WORK_DIR}/project/Field.h "#pragma once\n#define SECOND_FIELD after\n")
+    run_cmake(--build ${WORK_DIR}/build --target reflected_metadata)
+    expect_contains(${output} "\"after\"")
+    expect_lacks(${output} "\"before\"")
+
+elseif (CASE STREQUAL "imports")
+    # a module refers to the descriptors of the modules it imports rather than generating them again, here that of the specialization
+    # both name with an alias
+    file(WRITE ${WORK_DIR}/Base.h "#pragma once\nnamespace shared { template <typename T> struct Box { T value; }; using IntBox = Box<int>; }\n")
+    file(WRITE ${WORK_DIR}/Derived.h "#pragma once\n#include \"Base.h\"\nnamespace app { using Boxed = shared::Box<int>; struct Derived { int extra; }; }\n")
+    run_rwc(${WORK_DIR}/Base.h -n Base -o ${WORK_DIR}/Base.metadata.h -j ${WORK_DIR}/Base.metadata.rwdb -i ${WORK_DIR}/Base.metadata.ids)
+    if (NOT EXISTS ${WORK_DIR}/Base.metadata.ids)
+        message(FATAL_ERROR "no identifier repository was written for Base.h")
+    endif()
+    run_rwc(${WORK_DIR}/Derived.h -n Derived -o ${WORK_DIR}/Derived.metadata.h -j ${WORK_DIR}/Derived.metadata.rwdb -import ${WORK_DIR}/Base.metadata.ids)
+    expect_contains(${WORK_DIR}/Base.metadata.h "struct meta_IntBox")
+    expect_contains(${WORK_DIR}/Derived.metadata.h "struct meta_Derived")
+    expect_contains(${WORK_DIR}/Derived.metadata.h "Base.metadata.h\"")
+    expect_contains(${WORK_DIR}/Derived.metadata.h "meta_IntBox")
+    expect_lacks(${WORK_DIR}/Derived.metadata.h "struct meta_Boxed")
+
+elseif (CASE STREQUAL "declarations")
+    # every class and enum declared in a namespace gets a header of its own, which the header of the module includes
+    file(WRITE ${WORK_DIR}/Shapes.h "#pragma once\nnamespace shapes { struct Circle { float radius; }; enum class Kind { round, square }; }\n")
+    run_rwc(${WORK_DIR}/Shapes.h -n Shapes -o ${WORK_DIR}/Shapes.metadata.h -j ${WORK_DIR}/Shapes.metadata.rwdb -declarations ${WORK_DIR}/Shapes.metadata)
+    expect_contains(${WORK_DIR}/Shapes.metadata/shapes.Circle.h "meta_Circle")
+    expect_contains(${WORK_DIR}/Shapes.metadata/shapes.Kind.h "meta_Kind")
+    expect_contains(${WORK_DIR}/Shapes.metadata.h "shapes.Circle.h\"")
+    expect_contains(${WORK_DIR}/Shapes.metadata.h "shapes.Kind.h\"")
+    expect_contains(${WORK_DIR}/Shapes.metadata/manifest.txt "shapes.Kind.h")
+
+    # the headers of declarations that are gone don't stay behind
+    file(WRITE ${WORK_DIR}/Shapes.h "#pragma once\nnamespace shapes { struct Circle { float radius; }; }\n")
+    run_rwc(${WORK_DIR}/Shapes.h -n Shapes -o ${WORK_DIR}/Shapes.metadata.h -j ${WORK_DIR}/Shapes.metadata.rwdb -declarations ${WORK_DIR}/Shapes.metadata)
+    if (EXISTS ${WORK_DIR}/Shapes.metadata/shapes.Kind.h)
+        message(FATAL_ERROR "the header of shapes::Kind was left behind")
+    endif()
+    expect_contains(${WORK_DIR}/Shapes.metadata/manifest.txt "shapes.Circle.h")
+    expect_lacks(${WORK_DIR}/Shapes.metadata/manifest.txt "shapes.Kind.h")
+
+elseif (CASE STREQUAL "module_interface")
+    file(WRITE ${WORK_DIR}/Exported.h "#pragma once\nnamespace exported { struct Thing { int value; }; }\n")
+    run_rwc(${WORK_DIR}/Exported.h -n Exported -o ${WORK_DIR}/Exported.metadata.h -j ${WORK_DIR}/Exported.metadata.rwdb -module-interface ${WORK_DIR}/Exported.metadata.cppm)
+    expect_contains(${WORK_DIR}/Exported.metadata.cppm "export module Exported.meta;")
+    expect_contains(${WORK_DIR}/Exported.metadata.cppm "meta_Thing")
+
+else()
+    message(FATAL_ERROR "rwc.cmake: unknown case ${CASE}")
+endif()